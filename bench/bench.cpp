@@ -0,0 +1,218 @@
+// Micro-benchmarks for the orbit math, built against the headless core library:
+//     scons platform=<platform> bench && ./bin/orbit2d_bench
+
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "kepler.hpp"
+#include "orbits.hpp"
+
+namespace {
+
+    const float eccentricities[] = {0.0, 0.3, 0.6, 0.9, 0.99};
+    const int body_counts[] = {1000, 10000, 100000};
+    const float standard_gravitational_parameter = 1000.0;
+
+    struct Population {
+        std::vector<float> time;
+        std::vector<double> epoch_time;  // the same times, for the OrbitElements overloads
+        std::vector<float> eccentricity;
+        std::vector<float> semi_major_axis;
+        std::vector<float> argument_of_periapsis;
+        std::vector<float> standard_gravitational_parameter;
+        std::vector<orbits::OrbitElements> elements;
+    };
+
+    Population make_population(const int count, const float eccentricity) {
+        std::mt19937 rng(count);
+        std::uniform_real_distribution<float> unit(0.0, 1.0);
+        Population population;
+        for (int i = 0; i < count; i++) {
+            const float a = 10.0 + 990.0 * unit(rng);
+            const float w = 2.0 * M_PI * unit(rng);
+            population.time.push_back(orbits::get_orbital_period(a, standard_gravitational_parameter) * unit(rng));
+            population.epoch_time.push_back(population.time.back());
+            population.eccentricity.push_back(eccentricity);
+            population.semi_major_axis.push_back(a);
+            population.argument_of_periapsis.push_back(w);
+            population.standard_gravitational_parameter.push_back(standard_gravitational_parameter);
+            population.elements.push_back(orbits::get_orbit_elements(eccentricity, a, w,
+                                                                     standard_gravitational_parameter));
+        }
+        return population;
+    }
+
+    // Keeps results observable so the optimizer cannot drop the benchmarked calls
+    volatile float sink;
+
+    /**
+    Runs body over the whole population until at least 50 ms have passed and returns the time per body.
+    */
+    double time_per_call(const int count, const std::function<void()> &body) {
+        using clock = std::chrono::steady_clock;
+        body();  // warm up caches
+        int repeats = 0;
+        const clock::time_point start = clock::now();
+        clock::duration elapsed;
+        do {
+            body();
+            repeats++;
+            elapsed = clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(50));
+        return std::chrono::duration<double, std::nano>(elapsed).count() / (static_cast<double>(repeats) * count);
+    }
+
+    void report(const char *name, const float eccentricity, const int count, const double ns) {
+        std::printf("%-58s %6.2f %8d %10.1f\n", name, eccentricity, count, ns);
+    }
+
+    template <typename T>
+    void report_iterations(const char *name, const Population &p, const float e, const int n) {
+        int total = 0;
+        int worst = 0;
+        for (int i = 0; i < n; i++) {
+            int iterations;
+            kepler::ecc_anomaly<T>(e, orbits::get_mean_anomaly(p.time[i], p.elements[i]), iterations);
+            total += iterations;
+            worst = iterations > worst ? iterations : worst;
+        }
+        std::printf("%-58s %6.2f %8d %10s   iterations mean %.2f max %d\n", name, e, n, "",
+                    static_cast<double>(total) / n, worst);
+    }
+
+    void bench_kepler(const Population &p, const float e, const int n) {
+        report_iterations<double>("kepler::ecc_anomaly<double> iterations", p, e, n);
+        report_iterations<float>("kepler::ecc_anomaly<float> iterations", p, e, n);
+
+        std::vector<double> ecc(n, e), mean_anomaly(n), eccentric_anomaly(n);
+        for (int i = 0; i < n; i++) {
+            mean_anomaly[i] = orbits::get_mean_anomaly(p.time[i], p.elements[i]);
+        }
+        report("kepler::ecc_anomaly<double>", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) sum += kepler::ecc_anomaly<double>(e, mean_anomaly[i]);
+            sink = sum;
+        }));
+        report("kepler::ecc_anomaly<float>", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) sum += kepler::ecc_anomaly<float>(e, mean_anomaly[i]);
+            sink = sum;
+        }));
+        report("kepler::ecc_anomaly_batch", e, n, time_per_call(n, [&] {
+            kepler::ecc_anomaly_batch(ecc.data(), mean_anomaly.data(), eccentric_anomaly.data(), n);
+            sink = eccentric_anomaly[n - 1];
+        }));
+    }
+
+    void bench_from_time(const Population &p, const float e, const int n) {
+        report("orbits::get_eccentric_anomaly", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_eccentric_anomaly(p.time[i], e, p.semi_major_axis[i], p.argument_of_periapsis[i],
+                                                     standard_gravitational_parameter);
+            }
+            sink = sum;
+        }));
+        report("orbits::get_true_anomaly_from_time", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_true_anomaly_from_time(p.time[i], e, p.semi_major_axis[i],
+                                                          p.argument_of_periapsis[i], standard_gravitational_parameter);
+            }
+            sink = sum;
+        }));
+        report("orbits::get_heliocentric_distance_from_time", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_heliocentric_distance_from_time(p.time[i], e, p.semi_major_axis[i],
+                                                                   p.argument_of_periapsis[i],
+                                                                   standard_gravitational_parameter);
+            }
+            sink = sum;
+        }));
+        report("orbits::get_heliocentric_velocity_from_time", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_heliocentric_velocity_from_time(p.time[i], e, p.semi_major_axis[i],
+                                                                   p.argument_of_periapsis[i],
+                                                                   standard_gravitational_parameter).x;
+            }
+            sink = sum;
+        }));
+        report("orbits::get_heliocentric_position_velocity_from_time", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_heliocentric_position_velocity_from_time(p.time[i], e, p.semi_major_axis[i],
+                                                                            p.argument_of_periapsis[i],
+                                                                            standard_gravitational_parameter).p.x;
+            }
+            sink = sum;
+        }));
+        report("  (OrbitElements)", e, n, time_per_call(n, [&] {
+            float sum = 0;
+            for (int i = 0; i < n; i++) {
+                sum += orbits::get_heliocentric_position_velocity_from_time(p.time[i], p.elements[i]).p.x;
+            }
+            sink = sum;
+        }));
+
+        std::vector<godot::Vector2> positions(n), velocities(n);
+        report("orbits::get_heliocentric_position_velocity_from_time_batch", e, n, time_per_call(n, [&] {
+            orbits::get_heliocentric_position_velocity_from_time_batch(
+                    n, p.time.data(), p.eccentricity.data(), p.semi_major_axis.data(),
+                    p.argument_of_periapsis.data(), p.standard_gravitational_parameter.data(), positions.data(),
+                    velocities.data());
+            sink = positions[n - 1].x;
+        }));
+        report("  (OrbitElements)", e, n, time_per_call(n, [&] {
+            orbits::get_heliocentric_position_velocity_from_time_batch(n, p.epoch_time.data(), p.elements.data(),
+                                                                      positions.data(), velocities.data());
+            sink = positions[n - 1].x;
+        }));
+    }
+
+    void bench_tessellation(const Population &p, const float e) {
+        // Whole orbits rather than bodies, so a smaller population is enough
+        const int n = 1000;
+        const int resolution = 100;
+        const int max_points = 4096;
+        std::vector<godot::Vector2> points(max_points);
+
+        report("orbits::get_ellipse_points (100 points)", e, n, time_per_call(n, [&] {
+            for (int i = 0; i < n; i++) orbits::get_ellipse_points(p.elements[i], resolution, points.data());
+            sink = points[resolution - 1].x;
+        }));
+
+        int total = 0;
+        for (int i = 0; i < n; i++) {
+            total += orbits::get_adaptive_ellipse_points(p.elements[i], 1.0, 0.5, max_points, nullptr);
+        }
+        report("orbits::get_adaptive_ellipse_points (0.5 px)", e, n, time_per_call(n, [&] {
+            for (int i = 0; i < n; i++) {
+                orbits::get_adaptive_ellipse_points(p.elements[i], 1.0, 0.5, max_points, points.data());
+            }
+            sink = points[0].x;
+        }));
+        std::printf("%-58s %6.2f %8d %10s   points mean %.1f\n", "  points per orbit", e, n, "",
+                    static_cast<double>(total) / n);
+    }
+
+}
+
+int main() {
+    std::printf("%-58s %6s %8s %10s\n", "function", "e", "bodies", "ns/call");
+    for (const float e : eccentricities) {
+        for (const int n : body_counts) {
+            const Population population = make_population(n, e);
+            bench_kepler(population, e, n);
+            bench_from_time(population, e, n);
+            if (n == body_counts[0]) {
+                bench_tessellation(population, e);
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+// Minimal stand-in for the parts of godot-cpp used by the orbit math (kepler, orbits, kepler_table, job_pool),
+// so that code can be built and benchmarked without the Godot runtime. Mirrors the godot-cpp 3.x signatures;
+// only put this directory on the include path of headless targets.
+
+#include <cmath>
+
+namespace godot {
+
+typedef float real_t;
+
+struct Vector2 {
+    real_t x;
+    real_t y;
+
+    Vector2() : x(0), y(0) {}
+    Vector2(real_t x, real_t y) : x(x), y(y) {}
+
+    Vector2 operator+(const Vector2 &p) const { return Vector2(x + p.x, y + p.y); }
+    Vector2 operator-(const Vector2 &p) const { return Vector2(x - p.x, y - p.y); }
+    Vector2 operator*(const real_t s) const { return Vector2(x * s, y * s); }
+    Vector2 operator/(const real_t s) const { return Vector2(x / s, y / s); }
+    Vector2 operator-() const { return Vector2(-x, -y); }
+    Vector2 &operator+=(const Vector2 &p) { x += p.x; y += p.y; return *this; }
+    Vector2 &operator-=(const Vector2 &p) { x -= p.x; y -= p.y; return *this; }
+    Vector2 &operator*=(const real_t s) { x *= s; y *= s; return *this; }
+    bool operator==(const Vector2 &p) const { return x == p.x && y == p.y; }
+    bool operator!=(const Vector2 &p) const { return x != p.x || y != p.y; }
+
+    real_t length() const { return std::sqrt(x * x + y * y); }
+    real_t length_squared() const { return x * x + y * y; }
+    real_t distance_to(const Vector2 &p) const { return (*this - p).length(); }
+    real_t distance_squared_to(const Vector2 &p) const { return (*this - p).length_squared(); }
+    real_t dot(const Vector2 &p) const { return x * p.x + y * p.y; }
+    real_t cross(const Vector2 &p) const { return x * p.y - y * p.x; }
+    real_t angle() const { return std::atan2(y, x); }
+    real_t angle_to(const Vector2 &p) const { return std::atan2(cross(p), dot(p)); }
+
+    Vector2 normalized() const {
+        const real_t l = length();
+        return l == 0 ? Vector2() : Vector2(x / l, y / l);
+    }
+
+    Vector2 rotated(const real_t by) const {
+        const real_t c = std::cos(by);
+        const real_t s = std::sin(by);
+        return Vector2(x * c - y * s, x * s + y * c);
+    }
+};
+
+inline Vector2 operator*(const real_t s, const Vector2 &p) { return p * s; }
+
+namespace Math {
+    inline double sin(double x) { return std::sin(x); }
+    inline float sin(float x) { return std::sin(x); }
+    inline double cos(double x) { return std::cos(x); }
+    inline float cos(float x) { return std::cos(x); }
+    inline double tan(double x) { return std::tan(x); }
+    inline float tan(float x) { return std::tan(x); }
+    inline double atan2(double y, double x) { return std::atan2(y, x); }
+    inline float atan2(float y, float x) { return std::atan2(y, x); }
+    inline double sqrt(double x) { return std::sqrt(x); }
+    inline float sqrt(float x) { return std::sqrt(x); }
+    inline double abs(double x) { return std::abs(x); }
+    inline float abs(float x) { return std::abs(x); }
+    inline double pow(double x, double y) { return std::pow(x, y); }
+    inline float pow(float x, float y) { return std::pow(x, y); }
+    inline double fmod(double x, double y) { return std::fmod(x, y); }
+    inline float fmod(float x, float y) { return std::fmod(x, y); }
+    inline double floor(double x) { return std::floor(x); }
+    inline float floor(float x) { return std::floor(x); }
+}
+}
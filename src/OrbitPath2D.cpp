@@ -1,17 +1,32 @@
+#include <Engine.hpp>
+
 #include "OrbitPath2D.hpp"
 #include "orbits.hpp"
+#include "stats.hpp"
 
 using namespace godot;
 
+// Upper bound on the vertices of a level-of-detail tessellation, reached only for orbits far larger than the screen
+static const int lod_max_points = 4096;
+// Relative change of the on-screen size that triggers a new level-of-detail tessellation
+static const float lod_rebuild_threshold = 0.1;
+
 // TODO
 void OrbitPath2D::_register_methods() {
     register_method("_draw", &OrbitPath2D::_draw);
     register_method("_init", &OrbitPath2D::_init);
+    register_method("_ready", &OrbitPath2D::_ready);
+    register_method("_process", &OrbitPath2D::_process);
+    register_method("generate_path", &OrbitPath2D::generate_path);
+    register_method("update_path", &OrbitPath2D::update_path);
     register_property<OrbitPath2D, float>("semi_major_axis", &OrbitPath2D::set_semi_major_axis, &OrbitPath2D::get_semi_major_axis, 10.0);
     register_property<OrbitPath2D, float>("eccentricity", &OrbitPath2D::set_eccentricity, &OrbitPath2D::get_eccentricity, 0.0);
     register_property<OrbitPath2D, float>("argument_of_periapsis", &OrbitPath2D::set_argument_of_periapsis, &OrbitPath2D::get_argument_of_periapsis, 0.0);
+    register_property<OrbitPath2D, float>("standard_gravitational_parameter", &OrbitPath2D::set_standard_gravitational_parameter, &OrbitPath2D::get_standard_gravitational_parameter, 1.0);
     register_property<OrbitPath2D, int>("draw_resolution", &OrbitPath2D::set_draw_resolution, &OrbitPath2D::get_draw_resolution, 100);
     register_property<OrbitPath2D, Color>("draw_color", &OrbitPath2D::set_draw_color, &OrbitPath2D::get_draw_color, godot::Color(0,0,0));
+    register_property<OrbitPath2D, bool>("lod_enabled", &OrbitPath2D::set_lod_enabled, &OrbitPath2D::get_lod_enabled, false);
+    register_property<OrbitPath2D, float>("lod_max_screen_error", &OrbitPath2D::set_lod_max_screen_error, &OrbitPath2D::get_lod_max_screen_error, 0.5);
 }
 
 OrbitPath2D::OrbitPath2D() {}
@@ -20,79 +35,138 @@ OrbitPath2D::~OrbitPath2D() {}
 // Godot functions
 void OrbitPath2D::_init() {
     semi_major_axis = 10.0;
-    _semi_minor_axis = 10.0;
     eccentricity = 0.0;  // Starts as a circle
     argument_of_periapsis = 0.0;
+    standard_gravitational_parameter = 1.0;
+    _elements = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, standard_gravitational_parameter);
     draw_resolution = 100;
     draw_color = Color(0,0,0);
+    lod_enabled = false;
+    lod_max_screen_error = 0.5;
+    _draw_points_dirty = true;
+    _draw_points_scale = 1.0;
+    _path_dirty = false;
+    _queue_path_update();
+}
+void OrbitPath2D::_ready() {
+    // Godot turns processing on for every script with a _process, only level of detail needs it
+    set_process(lod_enabled);
 }
-//void OrbitPath2D::_ready() {}
 
 //void OrbitPath2D::_physics_process(float delta) {
 //	_path_follow->set_offset(_path_follow->get_offset() + get_velocity() * delta);
 //}
 
-void OrbitPath2D::_draw() {draw_ellipse();}
+void OrbitPath2D::_draw() {
+    stats::flush_frame(Engine::get_singleton()->get_idle_frames());
+    draw_ellipse();
+}
+
+void OrbitPath2D::_process(float delta) {
+    // Zooming or scaling does not redraw the canvas item on its own, so retessellate once the on-screen size has
+    // drifted far enough from the one the cached points were built for
+    const float scale = get_screen_scale();
+    if (Math::abs(scale - _draw_points_scale) > lod_rebuild_threshold * _draw_points_scale) {
+        _draw_points_dirty = true;
+        update();
+    }
+}
 
 void OrbitPath2D::draw_ellipse() {
-	// REF: https://www.mathopenref.com/coordcirclealgorithm.html
-	const int nb_points = get_draw_resolution();
-	float theta = 0.0;  // angle that will be increased each loop
-	const float step = M_2_PI / nb_points;  // amount to add to theta each time (radians)
-    auto centroid = orbits::get_centroid_from_focus_point(eccentricity, semi_major_axis, argument_of_periapsis, get_focus_point());
-	PoolVector2Array points;
-
-	int i = 0;
-	while (theta < M_2_PI) {
-		const real_t x = semi_major_axis*Math::cos(theta) + centroid.x;
-		const real_t y = get_semi_minor_axis()*Math::sin(theta) + centroid.y;
-		// Rotate by argument of periapsis
-		const real_t x_ = x*Math::cos(argument_of_periapsis) - y*godot::Math::sin(argument_of_periapsis);
-		const real_t y_ = x*Math::sin(argument_of_periapsis) + y*godot::Math::cos(argument_of_periapsis);
-		points.push_back(Vector2{x_, y_}-centroid);
-		theta += step;
-		i++;
-	}
-	for (int i = 0; i < nb_points-1; i++) {
-		draw_line(points[i], points[i+1], draw_color);
-	}
-	draw_line(points[nb_points-1], points[0], draw_color);
+    if (_draw_points_dirty) {
+        stats::ScopedTimer timer(stats::TIMER_TESSELLATION);
+        if (lod_enabled) {
+            _draw_points_scale = get_screen_scale();
+            const int nb_points = orbits::get_adaptive_ellipse_points(_elements, _draw_points_scale,
+                                                                      lod_max_screen_error, lod_max_points, nullptr);
+            // One extra point repeats periapsis to close the loop
+            _draw_points.resize(nb_points + 1);
+            PoolVector2Array::Write points = _draw_points.write();
+            orbits::get_adaptive_ellipse_points(_elements, _draw_points_scale, lod_max_screen_error, lod_max_points,
+                                                points.ptr());
+            points[nb_points] = points[0];
+        } else {
+            const int nb_points = get_draw_resolution() < 3 ? 3 : get_draw_resolution();
+            _draw_points.resize(nb_points + 1);
+            PoolVector2Array::Write points = _draw_points.write();
+            orbits::get_ellipse_points(_elements, nb_points, points.ptr());
+            points[nb_points] = points[0];
+        }
+        _draw_points_dirty = false;
+    }
+    draw_polyline(_draw_points, draw_color);
+}
+
+float OrbitPath2D::get_screen_scale() {
+    // Geometric mean of the axis scales of the local to screen transform, i.e. pixels per local unit
+    const float scale = Math::sqrt(Math::abs(get_global_transform_with_canvas().basis_determinant()));
+    return scale > 0.0 ? scale : 1.0;
 }
 
 // Important Functions
 void OrbitPath2D::generate_path() {
-    const float a = semi_major_axis;
-    const float b = get_semi_minor_axis();
-    auto curve = get_curve();
-    auto centroid = orbits::get_centroid_from_focus_point(eccentricity, semi_major_axis, argument_of_periapsis, get_focus_point());
+    stats::ScopedTimer timer(stats::TIMER_GENERATE_PATH);
+    _path_dirty = false;
+    Ref<Curve2D> curve = get_curve();
+    if (curve.is_null()) return;
+
+    // Four cubic Bezier arcs, one per quadrant of eccentric anomaly starting at periapsis. Handles of kappa
+    // times the opposite semi-axis keep the radial error of each arc below 0.03% of the axes.
+    const float kappa = 0.5522847498;  // 4/3 (sqrt(2) - 1)
+    const Vector2 centroid = orbits::get_centroid_from_focus_point(_elements, Vector2());
+    const Vector2 major = Vector2(_elements.cos_argument_of_periapsis, _elements.sin_argument_of_periapsis) * _elements.semi_major_axis;
+    const Vector2 minor = Vector2(-_elements.sin_argument_of_periapsis, _elements.cos_argument_of_periapsis) * _elements.semi_minor_axis;
+
     curve->clear_points();
-	curve->add_point(centroid+Vector2(b,0),godot::Vector2(0,-a));
-	curve->add_point(centroid+Vector2(0,a),godot::Vector2(b,0));
-	curve->add_point(centroid+Vector2(-b,0),godot::Vector2(0,a));
-	curve->add_point(centroid+Vector2(0,-a),godot::Vector2(-b,0));
-	curve->add_point(centroid+Vector2(b,0),godot::Vector2(0,-a));
+    curve->add_point(centroid + major, -minor * kappa, minor * kappa);
+    curve->add_point(centroid + minor, major * kappa, -major * kappa);
+    curve->add_point(centroid - major, minor * kappa, -minor * kappa);
+    curve->add_point(centroid - minor, -major * kappa, major * kappa);
+    curve->add_point(centroid + major, -minor * kappa, minor * kappa);
+}
+
+void OrbitPath2D::update_path() {
+    if (_path_dirty) {
+        generate_path();
+    }
+}
+
+void OrbitPath2D::_queue_path_update() {
+    // Coalesce every change made this frame into a single rebuild (and a single re-bake by PathFollow2D children)
+    if (_path_dirty) return;
+    _path_dirty = true;
+    call_deferred("update_path");
 }
 
 // Setters
 void OrbitPath2D::set_semi_major_axis(const float value) {
     semi_major_axis = value;
-    _semi_minor_axis = orbits::get_semi_minor_axis(eccentricity, semi_major_axis);
+    _elements = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, standard_gravitational_parameter);
+    _draw_points_dirty = true;
     // _cached_angular_velocity = 0.0;
-    generate_path();
+    _queue_path_update();
     update();
 }
 void OrbitPath2D::set_eccentricity(const float value) {
     eccentricity = value;
+    _elements = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, standard_gravitational_parameter);
+    _draw_points_dirty = true;
     // _cached_angular_velocity = 0.0;
-    generate_path();
+    _queue_path_update();
     update();
 }
 void OrbitPath2D::set_argument_of_periapsis(const float value) {
     argument_of_periapsis = value;
+    _elements = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, standard_gravitational_parameter);
+    _draw_points_dirty = true;
     // _cached_angular_velocity = 0.0;
-    generate_path();
+    _queue_path_update();
     update();
 }
+void OrbitPath2D::set_standard_gravitational_parameter(const float value) {
+    standard_gravitational_parameter = value;
+    _elements = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, standard_gravitational_parameter);
+}
 //void OrbitPath2D::set_gravity(const float value) {
 //    gravity = value;
 //    _standard_gravitational_area = gravity / Math::pow(gravity_distance_scale, 2.0);
@@ -100,12 +174,22 @@ void OrbitPath2D::set_argument_of_periapsis(const float value) {
 //}
 void OrbitPath2D::set_draw_resolution(const int value) {
     draw_resolution = value;
-    generate_path();
+    _draw_points_dirty = true;
     update();
 }
 void OrbitPath2D::set_draw_color(const Color value) {
     draw_color = value;
-    generate_path();
+    update();
+}
+void OrbitPath2D::set_lod_enabled(const bool value) {
+    lod_enabled = value;
+    set_process(lod_enabled);
+    _draw_points_dirty = true;
+    update();
+}
+void OrbitPath2D::set_lod_max_screen_error(const float value) {
+    lod_max_screen_error = value > 0.01 ? value : 0.01;
+    _draw_points_dirty = true;
     update();
 }
 
@@ -113,17 +197,23 @@ void OrbitPath2D::set_draw_color(const Color value) {
 float OrbitPath2D::get_semi_major_axis() {return semi_major_axis;}
 float OrbitPath2D::get_eccentricity() {return eccentricity;}
 float OrbitPath2D::get_argument_of_periapsis() {return argument_of_periapsis;}
+float OrbitPath2D::get_standard_gravitational_parameter() {return standard_gravitational_parameter;}
 //float OrbitPath2D::get_gravity() {return gravity;}
 int OrbitPath2D::get_draw_resolution() {return draw_resolution;}
+bool OrbitPath2D::get_lod_enabled() {return lod_enabled;}
+float OrbitPath2D::get_lod_max_screen_error() {return lod_max_screen_error;}
 
 // Memoized Getters
 float OrbitPath2D::get_semi_minor_axis() {
-  return _semi_minor_axis;
+  return _elements.semi_minor_axis;
+}
+const orbits::OrbitElements &OrbitPath2D::get_elements() const {
+  return _elements;
 }
 //Vector2 OrbitPath2D::get_velocity() {
 //    // TODO: Handle circular obits with a cached velocity
 //    Vector2 v = get_heliocentric_velocity_from_eccentric_anomaly(
-//        get_eccentric_anomaly_from_position(position, focus_point),
+//        get_eccentric_anomaly_from_position(position, focus_point, _elements),
 //        eccentricity,
 //        semi_major_axis,
 //        argument_of_periapsis,
@@ -139,9 +229,6 @@ float OrbitPath2D::get_semi_minor_axis() {
 //Area2D* OrbitPath2D::get_area() {
 //    return _area;
 //}
-//float OrbitPath2D::get_standard_gravitational_parameter() {
-//    return _standard_gravitational_area;
-//}
 Vector2 OrbitPath2D::get_focus_point() {
     return get_position();
 }
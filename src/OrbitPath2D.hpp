@@ -9,6 +9,8 @@
 #include <PathFollow2D.hpp>
 #include <PhysicsBody2D.hpp>
 
+#include "orbits.hpp"
+
 namespace godot {
 
 class OrbitPath2D : public Path2D {
@@ -20,13 +22,21 @@ private:
     float semi_major_axis;
     float eccentricity;
     float argument_of_periapsis;
-    float draw_resolution;
+    float standard_gravitational_parameter;
+    int draw_resolution;
     Color draw_color;
+    bool lod_enabled;
+    float lod_max_screen_error;
 
     // Memoizations
-    float _semi_minor_axis;
+    orbits::OrbitElements _elements;
+    PoolVector2Array _draw_points;
+    bool _draw_points_dirty;
+    float _draw_points_scale;
+    bool _path_dirty;
+
+    void _queue_path_update();
     // float _cached_angular_velocity;
-    // float _standard_gravitational_parameter;
     // PhysicsBody2D *_body;
     // PathFollow2D *_path_follow;
     // Area2D *_area;
@@ -39,13 +49,19 @@ public:
     ~OrbitPath2D();
 
     void _init();
+    void _ready();
     void _draw();
+    void _process(float delta);
 
     // Important Functions
     void generate_path();
 
+    void update_path();
+
     void draw_ellipse();
 
+    float get_screen_scale();
+
     // Setters
     void set_semi_major_axis(const float value);
 
@@ -53,10 +69,16 @@ public:
 
     void set_argument_of_periapsis(const float value);
 
+    void set_standard_gravitational_parameter(const float value);
+
     void set_draw_resolution(const int value);
 
     void set_draw_color(const Color value);
 
+    void set_lod_enabled(const bool value);
+
+    void set_lod_max_screen_error(const float value);
+
     //  void set_gravity(const float value);
 
     // Getters
@@ -66,15 +88,23 @@ public:
 
     float get_argument_of_periapsis();
 
+    float get_standard_gravitational_parameter();
+
     int get_draw_resolution();
 
     Color get_draw_color();
 
+    bool get_lod_enabled();
+
+    float get_lod_max_screen_error();
+
     // float get_gravity();
 
     // Memoized Getters
     float get_semi_minor_axis();
 
+    const orbits::OrbitElements &get_elements() const;
+
     // Vector2 get_velocity();
 
     Vector2 get_focus_point();
@@ -84,8 +114,6 @@ public:
     // PathFollow2D *get_path_follow();
 
     // Area2D *get_area();
-
-    // float get_standard_gravitational_parameter();
 };
 
 }
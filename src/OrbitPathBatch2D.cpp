@@ -0,0 +1,177 @@
+#include <Engine.hpp>
+
+#include "OrbitPathBatch2D.hpp"
+#include "job_pool.hpp"
+#include "stats.hpp"
+
+using namespace godot;
+
+// Orbits per task handed to the job pool when rebuilding the vertex buffer
+static const int tessellation_grain_size = 64;
+
+void OrbitPathBatch2D::_register_methods() {
+    register_method("_init", &OrbitPathBatch2D::_init);
+    register_method("_draw", &OrbitPathBatch2D::_draw);
+    register_method("add_orbit", &OrbitPathBatch2D::add_orbit);
+    register_method("set_orbit", &OrbitPathBatch2D::set_orbit);
+    register_method("set_orbit_color", &OrbitPathBatch2D::set_orbit_color);
+    register_method("remove_orbit", &OrbitPathBatch2D::remove_orbit);
+    register_method("clear_orbits", &OrbitPathBatch2D::clear_orbits);
+    register_method("get_orbit_count", &OrbitPathBatch2D::get_orbit_count);
+    register_method("find_nearest_orbit", &OrbitPathBatch2D::find_nearest_orbit);
+    register_property<OrbitPathBatch2D, int>("draw_resolution", &OrbitPathBatch2D::set_draw_resolution, &OrbitPathBatch2D::get_draw_resolution, 64);
+    register_property<OrbitPathBatch2D, float>("line_width", &OrbitPathBatch2D::set_line_width, &OrbitPathBatch2D::get_line_width, 1.0);
+}
+
+OrbitPathBatch2D::OrbitPathBatch2D() {}
+OrbitPathBatch2D::~OrbitPathBatch2D() {}
+
+// Godot functions
+void OrbitPathBatch2D::_init() {
+    draw_resolution = 64;
+    line_width = 1.0;
+    _draw_points_dirty = true;
+}
+
+void OrbitPathBatch2D::_draw() {
+    stats::flush_frame(Engine::get_singleton()->get_idle_frames());
+    draw_orbits();
+}
+
+// Important Functions
+void OrbitPathBatch2D::draw_orbits() {
+    const int count = static_cast<int>(_elements.size());
+    if (count == 0) return;
+
+    if (_draw_points_dirty) {
+        stats::ScopedTimer timer(stats::TIMER_TESSELLATION);
+        const int resolution = draw_resolution;
+        if (static_cast<int>(_unit_circle.size()) != resolution) {
+            _unit_circle.resize(resolution);
+            orbits::get_ellipse_points(orbits::get_orbit_elements(0.0, 1.0, 0.0, 1.0), resolution,
+                                       _unit_circle.data());
+        }
+
+        // Every orbit emits resolution line segments, two vertices each, with one color per vertex
+        const int vertices_per_orbit = resolution * 2;
+        _draw_points.resize(count * vertices_per_orbit);
+        _draw_colors.resize(count * vertices_per_orbit);
+        PoolVector2Array::Write points = _draw_points.write();
+        PoolColorArray::Write colors = _draw_colors.write();
+        Vector2 *p = points.ptr();
+        Color *c = colors.ptr();
+        const Vector2 *unit_circle = _unit_circle.data();
+        const orbits::OrbitElements *elements = _elements.data();
+        const Vector2 *foci = _foci.data();
+        const Color *orbit_colors = _colors.data();
+
+        jobs::JobPool::get_singleton().parallel_for(count, tessellation_grain_size, [=](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const orbits::OrbitElements &el = elements[i];
+                // Columns of the transform taking the unit circle onto the orbit
+                const Vector2 x_axis = Vector2(el.cos_argument_of_periapsis, el.sin_argument_of_periapsis)
+                        * el.semi_major_axis;
+                const Vector2 y_axis = Vector2(-el.sin_argument_of_periapsis, el.cos_argument_of_periapsis)
+                        * el.semi_minor_axis;
+                const Vector2 origin = orbits::get_centroid_from_focus_point(el, foci[i]);
+
+                Vector2 *out = p + i * vertices_per_orbit;
+                Color *out_colors = c + i * vertices_per_orbit;
+                const Vector2 first = origin + x_axis * unit_circle[0].x + y_axis * unit_circle[0].y;
+                Vector2 previous = first;
+                for (int j = 1; j < resolution; j++) {
+                    const Vector2 vertex = origin + x_axis * unit_circle[j].x + y_axis * unit_circle[j].y;
+                    out[2 * j - 2] = previous;
+                    out[2 * j - 1] = vertex;
+                    previous = vertex;
+                }
+                out[vertices_per_orbit - 2] = previous;
+                out[vertices_per_orbit - 1] = first;
+                for (int j = 0; j < vertices_per_orbit; j++) {
+                    out_colors[j] = orbit_colors[i];
+                }
+            }
+        });
+        _draw_points_dirty = false;
+    }
+    draw_multiline_colors(_draw_points, _draw_colors, line_width);
+}
+
+int OrbitPathBatch2D::add_orbit(const Vector2 focus, const float eccentricity, const float semi_major_axis,
+                                const float argument_of_periapsis, const Color color) {
+    ERR_FAIL_COND_V(!(semi_major_axis > 0.0 && eccentricity >= 0.0 && eccentricity < 1.0), -1);
+    _elements.push_back(orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, 1.0));
+    _foci.push_back(focus);
+    _colors.push_back(color);
+    _draw_points_dirty = true;
+    update();
+    return static_cast<int>(_elements.size()) - 1;
+}
+
+void OrbitPathBatch2D::set_orbit(const int index, const Vector2 focus, const float eccentricity,
+                                 const float semi_major_axis, const float argument_of_periapsis) {
+    ERR_FAIL_INDEX(index, static_cast<int>(_elements.size()));
+    ERR_FAIL_COND(!(semi_major_axis > 0.0 && eccentricity >= 0.0 && eccentricity < 1.0));
+    _elements[index] = orbits::get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis, 1.0);
+    _foci[index] = focus;
+    _draw_points_dirty = true;
+    update();
+}
+
+void OrbitPathBatch2D::set_orbit_color(const int index, const Color color) {
+    ERR_FAIL_INDEX(index, static_cast<int>(_elements.size()));
+    _colors[index] = color;
+    if (!_draw_points_dirty) {
+        // The vertices stay where they are, only the colors of this orbit's segments change
+        const int vertices_per_orbit = draw_resolution * 2;
+        PoolColorArray::Write colors = _draw_colors.write();
+        Color *c = colors.ptr() + index * vertices_per_orbit;
+        for (int j = 0; j < vertices_per_orbit; j++) {
+            c[j] = color;
+        }
+    }
+    update();
+}
+
+void OrbitPathBatch2D::remove_orbit(const int index) {
+    ERR_FAIL_INDEX(index, static_cast<int>(_elements.size()));
+    _elements.erase(_elements.begin() + index);
+    _foci.erase(_foci.begin() + index);
+    _colors.erase(_colors.begin() + index);
+    _draw_points_dirty = true;
+    update();
+}
+
+void OrbitPathBatch2D::clear_orbits() {
+    _elements.clear();
+    _foci.clear();
+    _colors.clear();
+    _draw_points_dirty = true;
+    update();
+}
+
+int OrbitPathBatch2D::get_orbit_count() {
+    return static_cast<int>(_elements.size());
+}
+
+int OrbitPathBatch2D::find_nearest_orbit(const Vector2 point, const float max_distance) {
+    // Orbit passing closest to point, in local coordinates, -1 if none is within max_distance
+    orbits::NearestPoint nearest;
+    return orbits::find_nearest_orbit(static_cast<int>(_elements.size()), _elements.data(), _foci.data(), nullptr,
+                                      point, max_distance, 0.0, nearest);
+}
+
+// Setters
+void OrbitPathBatch2D::set_draw_resolution(const int value) {
+    draw_resolution = value < 3 ? 3 : value;
+    _draw_points_dirty = true;
+    update();
+}
+void OrbitPathBatch2D::set_line_width(const float value) {
+    line_width = value;
+    update();
+}
+
+// Getters
+int OrbitPathBatch2D::get_draw_resolution() {return draw_resolution;}
+float OrbitPathBatch2D::get_line_width() {return line_width;}
@@ -0,0 +1,84 @@
+#ifndef __ORBITPATHBATCH2D_H_
+#define __ORBITPATHBATCH2D_H_
+
+#include <vector>
+
+#include <Godot.hpp>
+#include <Node2D.hpp>
+
+#include "orbit_nearest.hpp"
+#include "orbits.hpp"
+
+namespace godot {
+
+/**
+Draws any number of orbit paths from a single canvas item.
+Every orbit is an affine transform of one shared unit circle, and all of them are submitted together as one
+multiline draw command with per-orbit colors, instead of one OrbitPath2D node (and one _draw) per orbit.
+
+find_nearest_orbit picks the orbit under the cursor, ruling out most orbits from their periapsis and apoapsis
+distance before solving for the closest point of the few that are left.
+*/
+class OrbitPathBatch2D : public Node2D {
+    GODOT_CLASS(OrbitPathBatch2D, Node2D
+    )
+
+private:
+    // User Defined
+    int draw_resolution;
+    float line_width;
+
+    // Orbits, stored as parallel arrays indexed by orbit id
+    std::vector<orbits::OrbitElements> _elements;
+    std::vector<Vector2> _foci;
+    std::vector<Color> _colors;
+
+    // Memoizations
+    std::vector<Vector2> _unit_circle;
+    PoolVector2Array _draw_points;
+    PoolColorArray _draw_colors;
+    bool _draw_points_dirty;
+
+public:
+    static void _register_methods();
+
+    OrbitPathBatch2D();
+
+    ~OrbitPathBatch2D();
+
+    void _init();
+    void _draw();
+
+    // Important Functions
+    void draw_orbits();
+
+    int add_orbit(const Vector2 focus, const float eccentricity, const float semi_major_axis,
+                  const float argument_of_periapsis, const Color color);
+
+    void set_orbit(const int index, const Vector2 focus, const float eccentricity, const float semi_major_axis,
+                   const float argument_of_periapsis);
+
+    void set_orbit_color(const int index, const Color color);
+
+    void remove_orbit(const int index);
+
+    void clear_orbits();
+
+    int get_orbit_count();
+
+    int find_nearest_orbit(const Vector2 point, const float max_distance);
+
+    // Setters
+    void set_draw_resolution(const int value);
+
+    void set_line_width(const float value);
+
+    // Getters
+    int get_draw_resolution();
+
+    float get_line_width();
+};
+
+}
+
+#endif // __ORBITPATHBATCH2D_H_
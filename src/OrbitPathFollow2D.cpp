@@ -0,0 +1,86 @@
+#include <cmath>
+
+#include <Engine.hpp>
+
+#include "OrbitPathFollow2D.hpp"
+#include "OrbitPath2D.hpp"
+#include "kepler.hpp"
+#include "orbits.hpp"
+#include "stats.hpp"
+
+using namespace godot;
+
+void OrbitPathFollow2D::_register_methods() {
+    register_method("_init", &OrbitPathFollow2D::_init);
+    register_method("_physics_process", &OrbitPathFollow2D::_physics_process);
+    register_method("advance", &OrbitPathFollow2D::advance);
+    register_method("get_eccentric_anomaly", &OrbitPathFollow2D::get_eccentric_anomaly);
+    register_method("get_velocity", &OrbitPathFollow2D::get_velocity);
+    register_property<OrbitPathFollow2D, double>("time", &OrbitPathFollow2D::set_time, &OrbitPathFollow2D::get_time, 0.0);
+    register_property<OrbitPathFollow2D, float>("time_scale", &OrbitPathFollow2D::set_time_scale, &OrbitPathFollow2D::get_time_scale, 1.0);
+}
+
+OrbitPathFollow2D::OrbitPathFollow2D() {}
+OrbitPathFollow2D::~OrbitPathFollow2D() {}
+
+// Godot functions
+void OrbitPathFollow2D::_init() {
+    time = 0.0;
+    time_scale = 1.0;
+    _mean_anomaly = 0.0;
+    _eccentric_anomaly = 0.0;
+    _solver_warm = false;
+}
+
+void OrbitPathFollow2D::_physics_process(float delta) {
+    stats::flush_frame(Engine::get_singleton()->get_idle_frames());
+    advance(delta * time_scale);
+}
+
+// Important Functions
+void OrbitPathFollow2D::advance(const float delta) {
+    OrbitPath2D *path = get_orbit_path();
+    if (!path) return;
+    stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+    stats::add_bodies_propagated(1);
+    const orbits::OrbitElements &elements = path->get_elements();
+
+    time += delta;
+    // Taken from the time every frame rather than accumulated, so no rounding error builds up
+    const double mean_anomaly = orbits::get_mean_anomaly(time, elements);
+    if (_solver_warm) {
+        // Move the previous solution onto the same turn as the new mean anomaly so it stays a valid guess
+        _eccentric_anomaly -= 2.0 * M_PI * std::round((_mean_anomaly - mean_anomaly) / (2.0 * M_PI));
+        _mean_anomaly = mean_anomaly;
+        _eccentric_anomaly = kepler::ecc_anomaly_from_guess(elements.eccentricity, _mean_anomaly, _eccentric_anomaly);
+    } else {
+        _mean_anomaly = mean_anomaly;
+        _eccentric_anomaly = kepler::ecc_anomaly(elements.eccentricity, _mean_anomaly);
+        _solver_warm = true;
+    }
+
+    const orbits::PositionVelocity2D pv = orbits::get_heliocentric_position_velocity_from_eccentric_anomaly(
+            _eccentric_anomaly, elements);
+    _velocity = pv.v;
+    set_position(pv.p);
+}
+
+OrbitPath2D *OrbitPathFollow2D::get_orbit_path() {
+    return Object::cast_to<OrbitPath2D>(get_parent());
+}
+
+// Setters
+void OrbitPathFollow2D::set_time(const double value) {
+    time = value;
+    // A jump in time can land anywhere on the orbit, so the next solve starts cold
+    _solver_warm = false;
+}
+void OrbitPathFollow2D::set_time_scale(const float value) {
+    time_scale = value;
+}
+
+// Getters
+double OrbitPathFollow2D::get_time() {return time;}
+float OrbitPathFollow2D::get_time_scale() {return time_scale;}
+float OrbitPathFollow2D::get_eccentric_anomaly() {return _eccentric_anomaly;}
+Vector2 OrbitPathFollow2D::get_velocity() {return _velocity;}
@@ -0,0 +1,63 @@
+#ifndef __ORBITPATHFOLLOW2D_H_
+#define __ORBITPATHFOLLOW2D_H_
+
+#include <Godot.hpp>
+#include <PathFollow2D.hpp>
+
+namespace godot {
+
+class OrbitPath2D;
+
+/**
+Moves along the orbit of its parent OrbitPath2D at the body's true orbital speed.
+Positions come from the analytic solution rather than from the baked curve, and the Kepler solve is warm
+started from the previous frame's eccentric anomaly, so a physics tick typically costs one or two corrections.
+*/
+class OrbitPathFollow2D : public PathFollow2D {
+    GODOT_CLASS(OrbitPathFollow2D, PathFollow2D
+    )
+
+private:
+    // User Defined
+    double time;
+    float time_scale;
+
+    // Solver state, mean anomaly kept in [0, 2 pi) and the eccentric anomaly on the same branch
+    double _mean_anomaly;
+    double _eccentric_anomaly;
+    bool _solver_warm;
+    Vector2 _velocity;
+
+    OrbitPath2D *get_orbit_path();
+
+public:
+    static void _register_methods();
+
+    OrbitPathFollow2D();
+
+    ~OrbitPathFollow2D();
+
+    void _init();
+    void _physics_process(float delta);
+
+    // Important Functions
+    void advance(const float delta);
+
+    // Setters
+    void set_time(const double value);
+
+    void set_time_scale(const float value);
+
+    // Getters
+    double get_time();
+
+    float get_time_scale();
+
+    float get_eccentric_anomaly();
+
+    Vector2 get_velocity();
+};
+
+}
+
+#endif // __ORBITPATHFOLLOW2D_H_
@@ -0,0 +1,233 @@
+#include <Engine.hpp>
+
+#include "OrbitServer.hpp"
+#include "stats.hpp"
+
+using namespace godot;
+
+// Values per orbit in the PoolRealArray of elements
+static const int element_stride = 6;
+
+OrbitServer *OrbitServer::_singleton = nullptr;
+
+void OrbitServer::_register_methods() {
+    register_method("_init", &OrbitServer::_init);
+    register_method("_process", &OrbitServer::_process);
+    register_method("create_orbit", &OrbitServer::create_orbit);
+    register_method("create_orbits", &OrbitServer::create_orbits);
+    register_method("update_orbit", &OrbitServer::update_orbit);
+    register_method("update_orbits", &OrbitServer::update_orbits);
+    register_method("free_orbit", &OrbitServer::free_orbit);
+    register_method("free_orbits", &OrbitServer::free_orbits);
+    register_method("clear_orbits", &OrbitServer::clear_orbits);
+    register_method("is_orbit_valid", &OrbitServer::is_orbit_valid);
+    register_method("get_orbit_count", &OrbitServer::get_orbit_count);
+    register_method("get_orbit_handles", &OrbitServer::get_orbit_handles);
+    register_method("get_orbit_elements", &OrbitServer::get_orbit_elements);
+    register_method("get_positions", &OrbitServer::get_positions);
+    register_method("get_velocities", &OrbitServer::get_velocities);
+    register_method("get_all_positions", &OrbitServer::get_all_positions);
+    register_method("find_orbits_in_rect", &OrbitServer::find_orbits_in_rect);
+    register_method("get_performance_stats", &OrbitServer::get_performance_stats);
+}
+
+OrbitServer *OrbitServer::get_singleton() {
+    return _singleton;
+}
+
+OrbitServer::OrbitServer() {}
+OrbitServer::~OrbitServer() {
+    if (_singleton == this) _singleton = nullptr;
+}
+
+// Godot functions
+void OrbitServer::_init() {
+    // The first instance, normally the AutoLoad, is the one C++ code talks to
+    if (!_singleton) _singleton = this;
+}
+
+void OrbitServer::_process(float delta) {
+    // Ends the frame of the counters unless another node has already done so this frame
+    stats::flush_frame(Engine::get_singleton()->get_idle_frames());
+}
+
+bool OrbitServer::_are_valid(const PoolIntArray &handles) {
+    PoolIntArray::Read read = handles.read();
+    for (int k = 0; k < handles.size(); k++) {
+        if (!_store.is_valid(read[k])) return false;
+    }
+    return true;
+}
+
+bool OrbitServer::_are_valid_records(const PoolRealArray &elements) {
+    PoolRealArray::Read e = elements.read();
+    for (int k = 0; k < elements.size() / element_stride; k++) {
+        const real_t *orbit = e.ptr() + k * element_stride;
+        if (!orbits::OrbitStore::is_valid_record({orbit[0], orbit[1], orbit[2], orbit[3], orbit[4], orbit[5]})) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Important Functions
+int OrbitServer::create_orbit(const float eccentricity, const float semi_major_axis,
+                              const float argument_of_periapsis, const float standard_gravitational_parameter,
+                              const double epoch, const double mean_anomaly_at_epoch) {
+    const orbits::OrbitRecord record = {eccentricity, semi_major_axis, argument_of_periapsis,
+                                        standard_gravitational_parameter, epoch, mean_anomaly_at_epoch};
+    ERR_FAIL_COND_V(!orbits::OrbitStore::is_valid_record(record), -1);
+    return _store.create(record);
+}
+
+PoolIntArray OrbitServer::create_orbits(const PoolRealArray elements) {
+    PoolIntArray result;
+    ERR_FAIL_COND_V(elements.size() % element_stride != 0, result);
+    ERR_FAIL_COND_V(!_are_valid_records(elements), result);
+    const int count = elements.size() / element_stride;
+    result.resize(count);
+    PoolRealArray::Read e = elements.read();
+    PoolIntArray::Write write = result.write();
+    for (int k = 0; k < count; k++) {
+        const real_t *orbit = e.ptr() + k * element_stride;
+        write[k] = _store.create({orbit[0], orbit[1], orbit[2], orbit[3], orbit[4], orbit[5]});
+    }
+    return result;
+}
+
+void OrbitServer::update_orbit(const int handle, const float eccentricity, const float semi_major_axis,
+                               const float argument_of_periapsis, const float standard_gravitational_parameter,
+                               const double epoch, const double mean_anomaly_at_epoch) {
+    const orbits::OrbitRecord record = {eccentricity, semi_major_axis, argument_of_periapsis,
+                                        standard_gravitational_parameter, epoch, mean_anomaly_at_epoch};
+    ERR_FAIL_COND(!orbits::OrbitStore::is_valid_record(record));
+    ERR_FAIL_COND(!_store.update(handle, record));
+}
+
+void OrbitServer::update_orbits(const PoolIntArray handles, const PoolRealArray elements) {
+    ERR_FAIL_COND(elements.size() != handles.size() * element_stride);
+    ERR_FAIL_COND(!_are_valid(handles));
+    ERR_FAIL_COND(!_are_valid_records(elements));
+    PoolIntArray::Read h = handles.read();
+    PoolRealArray::Read e = elements.read();
+    for (int k = 0; k < handles.size(); k++) {
+        const real_t *orbit = e.ptr() + k * element_stride;
+        _store.update(h[k], {orbit[0], orbit[1], orbit[2], orbit[3], orbit[4], orbit[5]});
+    }
+}
+
+void OrbitServer::free_orbit(const int handle) {
+    ERR_FAIL_COND(!_store.destroy(handle));
+}
+
+void OrbitServer::free_orbits(const PoolIntArray handles) {
+    ERR_FAIL_COND(!_are_valid(handles));
+    PoolIntArray::Read h = handles.read();
+    for (int k = 0; k < handles.size(); k++) {
+        _store.destroy(h[k]);
+    }
+}
+
+void OrbitServer::clear_orbits() {
+    _store.clear();
+}
+
+bool OrbitServer::is_orbit_valid(const int handle) {
+    return _store.is_valid(handle);
+}
+
+int OrbitServer::get_orbit_count() {
+    return _store.get_count();
+}
+
+PoolIntArray OrbitServer::get_orbit_handles() {
+    // In the order of get_all_positions
+    PoolIntArray result;
+    result.resize(_store.get_count());
+    PoolIntArray::Write write = result.write();
+    for (int index = 0; index < _store.get_count(); index++) {
+        write[index] = _store.get_handle(index);
+    }
+    return result;
+}
+
+PoolRealArray OrbitServer::get_orbit_elements(const PoolIntArray handles) {
+    PoolRealArray result;
+    ERR_FAIL_COND_V(!_are_valid(handles), result);
+    result.resize(handles.size() * element_stride);
+    PoolIntArray::Read h = handles.read();
+    PoolRealArray::Write write = result.write();
+    for (int k = 0; k < handles.size(); k++) {
+        const orbits::OrbitRecord &record = _store.get(h[k]);
+        real_t *orbit = write.ptr() + k * element_stride;
+        orbit[0] = record.eccentricity;
+        orbit[1] = record.semi_major_axis;
+        orbit[2] = record.argument_of_periapsis;
+        orbit[3] = record.standard_gravitational_parameter;
+        orbit[4] = record.epoch;
+        orbit[5] = record.mean_anomaly_at_epoch;
+    }
+    return result;
+}
+
+PoolVector2Array OrbitServer::get_positions(const PoolIntArray handles, const double time) {
+    PoolVector2Array result;
+    ERR_FAIL_COND_V(!_are_valid(handles), result);
+    stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+    stats::add_bodies_propagated(handles.size());
+    result.resize(handles.size());
+    PoolVector2Array::Write write = result.write();
+    _store.get_position_velocity_batch(handles.size(), handles.read().ptr(), time, write.ptr(), nullptr);
+    return result;
+}
+
+PoolVector2Array OrbitServer::get_velocities(const PoolIntArray handles, const double time) {
+    PoolVector2Array result;
+    ERR_FAIL_COND_V(!_are_valid(handles), result);
+    stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+    stats::add_bodies_propagated(handles.size());
+    result.resize(handles.size());
+    std::vector<Vector2> positions(handles.size());
+    PoolVector2Array::Write write = result.write();
+    _store.get_position_velocity_batch(handles.size(), handles.read().ptr(), time, positions.data(), write.ptr());
+    return result;
+}
+
+PoolVector2Array OrbitServer::get_all_positions(const double time) {
+    // In the order of get_orbit_handles
+    stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+    stats::add_bodies_propagated(_store.get_count());
+    PoolVector2Array result;
+    result.resize(_store.get_count());
+    PoolVector2Array::Write write = result.write();
+    _store.get_position_velocity_batch(_store.get_count(), nullptr, time, write.ptr(), nullptr);
+    return result;
+}
+
+PoolIntArray OrbitServer::find_orbits_in_rect(const Rect2 rect, const double time) {
+    std::vector<int> found;
+    _store.find_in_rect(rect.position, rect.position + rect.size, time, found);
+    PoolIntArray result;
+    result.resize(static_cast<int>(found.size()));
+    PoolIntArray::Write write = result.write();
+    for (int k = 0; k < static_cast<int>(found.size()); k++) {
+        write[k] = found[k];
+    }
+    return result;
+}
+
+Dictionary OrbitServer::get_performance_stats() {
+    const stats::Frame frame = stats::get_frame();
+    Array iterations;
+    for (int i = 0; i < stats::kepler_histogram_size; i++) {
+        iterations.append(static_cast<int64_t>(frame.kepler_iterations[i]));
+    }
+    Dictionary result;
+    result["kepler_iterations"] = iterations;
+    result["kepler_failures"] = static_cast<int64_t>(frame.kepler_failures);
+    result["bodies_propagated"] = static_cast<int64_t>(frame.bodies_propagated);
+    result["propagation_ns"] = static_cast<int64_t>(frame.timer_ns[stats::TIMER_PROPAGATION]);
+    result["tessellation_ns"] = static_cast<int64_t>(frame.timer_ns[stats::TIMER_TESSELLATION]);
+    result["generate_path_ns"] = static_cast<int64_t>(frame.timer_ns[stats::TIMER_GENERATE_PATH]);
+    return result;
+}
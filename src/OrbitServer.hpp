@@ -0,0 +1,95 @@
+#ifndef __ORBITSERVER_H_
+#define __ORBITSERVER_H_
+
+#include <Godot.hpp>
+#include <Node.hpp>
+
+#include "orbit_store.hpp"
+
+namespace godot {
+
+/**
+Holds orbits that have no node of their own, addressed by integer handles, in the spirit of the engine's servers.
+Add it as an AutoLoad; C++ code reaches the instance through get_singleton.
+
+An orbit costs about 41 bytes here against kilobytes for an OrbitPath2D with its Curve2D and canvas item, so a
+million of them fit in a few tens of MB. Orbits are created, updated and queried in bulk through packed arrays,
+every query is split across the job pool, and find_orbits_in_rect picks the few that are on screen and should be
+backed by nodes.
+
+Elements travel as PoolRealArray with 6 values per orbit: eccentricity, semi-major axis, argument of periapsis,
+standard gravitational parameter, epoch and mean anomaly at epoch. Positions and velocities are relative to the
+focus of each orbit. Only ellipses are stored: calls passing a semi-major axis that is not positive or an
+eccentricity outside [0, 1) fail as a whole and change nothing.
+
+The instance also ends the frame of the solver and propagation counters, see stats.hpp, in its _process, as every
+node producing counts does on its first callback of the frame. get_performance_stats returns the numbers of the last
+frame: a histogram of the corrections the Kepler solves took, the solves that gave up before converging, the bodies
+propagated and the nanoseconds spent propagating, tessellating orbits for drawing and generating OrbitPath2D curves.
+*/
+class OrbitServer : public Node {
+    GODOT_CLASS(OrbitServer, Node
+    )
+
+private:
+    orbits::OrbitStore _store;
+
+    static OrbitServer *_singleton;
+
+public:
+    static void _register_methods();
+
+    static OrbitServer *get_singleton();
+
+    OrbitServer();
+
+    ~OrbitServer();
+
+    void _init();
+    void _process(float delta);
+
+    bool _are_valid(const PoolIntArray &handles);
+
+    bool _are_valid_records(const PoolRealArray &elements);
+
+    // Important Functions
+    int create_orbit(const float eccentricity, const float semi_major_axis, const float argument_of_periapsis,
+                     const float standard_gravitational_parameter, const double epoch,
+                     const double mean_anomaly_at_epoch);
+
+    PoolIntArray create_orbits(const PoolRealArray elements);
+
+    void update_orbit(const int handle, const float eccentricity, const float semi_major_axis,
+                      const float argument_of_periapsis, const float standard_gravitational_parameter,
+                      const double epoch, const double mean_anomaly_at_epoch);
+
+    void update_orbits(const PoolIntArray handles, const PoolRealArray elements);
+
+    void free_orbit(const int handle);
+
+    void free_orbits(const PoolIntArray handles);
+
+    void clear_orbits();
+
+    bool is_orbit_valid(const int handle);
+
+    int get_orbit_count();
+
+    PoolIntArray get_orbit_handles();
+
+    PoolRealArray get_orbit_elements(const PoolIntArray handles);
+
+    PoolVector2Array get_positions(const PoolIntArray handles, const double time);
+
+    PoolVector2Array get_velocities(const PoolIntArray handles, const double time);
+
+    PoolVector2Array get_all_positions(const double time);
+
+    PoolIntArray find_orbits_in_rect(const Rect2 rect, const double time);
+
+    Dictionary get_performance_stats();
+};
+
+}
+
+#endif // __ORBITSERVER_H_
@@ -0,0 +1,459 @@
+#include <algorithm>
+#include <vector>
+
+#include <Engine.hpp>
+
+#include "OrbitSystem2D.hpp"
+#include "stats.hpp"
+
+using namespace godot;
+
+// Values per point in the PoolRealArray of get_nearest_points
+static const int nearest_stride = 6;
+
+void OrbitSystem2D::_register_methods() {
+    register_method("_init", &OrbitSystem2D::_init);
+    register_method("_physics_process", &OrbitSystem2D::_physics_process);
+    register_method("propagate", &OrbitSystem2D::propagate);
+    register_method("advance", &OrbitSystem2D::advance);
+    register_method("add_body", &OrbitSystem2D::add_body);
+    register_method("add_body_at_epoch", &OrbitSystem2D::add_body_at_epoch);
+    register_method("set_body", &OrbitSystem2D::set_body);
+    register_method("remove_body", &OrbitSystem2D::remove_body);
+    register_method("clear_bodies", &OrbitSystem2D::clear_bodies);
+    register_method("get_body_count", &OrbitSystem2D::get_body_count);
+    register_method("set_body_radius", &OrbitSystem2D::set_body_radius);
+    register_method("get_body_radius", &OrbitSystem2D::get_body_radius);
+    register_method("set_body_visible", &OrbitSystem2D::set_body_visible);
+    register_method("is_body_visible", &OrbitSystem2D::is_body_visible);
+    register_method("get_pending_event_count", &OrbitSystem2D::get_pending_event_count);
+    register_method("set_body_parent", &OrbitSystem2D::set_body_parent);
+    register_method("get_body_parent", &OrbitSystem2D::get_body_parent);
+    register_method("set_body_standard_gravitational_parameter", &OrbitSystem2D::set_body_standard_gravitational_parameter);
+    register_method("get_body_standard_gravitational_parameter", &OrbitSystem2D::get_body_standard_gravitational_parameter);
+    register_method("set_body_thrust", &OrbitSystem2D::set_body_thrust);
+    register_method("get_body_thrust", &OrbitSystem2D::get_body_thrust);
+    register_method("is_body_off_rails", &OrbitSystem2D::is_body_off_rails);
+    register_method("set_body_state", &OrbitSystem2D::set_body_state);
+    register_method("set_body_perturbed", &OrbitSystem2D::set_body_perturbed);
+    register_method("is_body_perturbed", &OrbitSystem2D::is_body_perturbed);
+    register_method("get_foci", &OrbitSystem2D::get_foci);
+    register_method("find_soi", &OrbitSystem2D::find_soi);
+    register_method("find_sois", &OrbitSystem2D::find_sois);
+    register_method("update_soi_transitions", &OrbitSystem2D::update_soi_transitions);
+    register_method("get_positions", &OrbitSystem2D::get_positions);
+    register_method("get_velocities", &OrbitSystem2D::get_velocities);
+    register_method("get_intercepting_body_pairs", &OrbitSystem2D::get_intercepting_body_pairs);
+    register_method("get_intercept_points", &OrbitSystem2D::get_intercept_points);
+    register_method("get_next_overlap_times", &OrbitSystem2D::get_next_overlap_times);
+    register_method("get_transfer_velocities", &OrbitSystem2D::get_transfer_velocities);
+    register_method("get_porkchop_plot", &OrbitSystem2D::get_porkchop_plot);
+    register_method("get_nearest_points", &OrbitSystem2D::get_nearest_points);
+    register_method("find_nearest_body", &OrbitSystem2D::find_nearest_body);
+    register_method("get_kepler_table_count", &OrbitSystem2D::get_kepler_table_count);
+    register_method("get_kepler_table_memory_usage", &OrbitSystem2D::get_kepler_table_memory_usage);
+    register_property<OrbitSystem2D, float>("standard_gravitational_parameter", &OrbitSystem2D::set_standard_gravitational_parameter, &OrbitSystem2D::get_standard_gravitational_parameter, 1.0);
+    register_property<OrbitSystem2D, float>("time_scale", &OrbitSystem2D::set_time_scale, &OrbitSystem2D::get_time_scale, 1.0);
+    register_property<OrbitSystem2D, double>("time", &OrbitSystem2D::set_time, &OrbitSystem2D::get_time, 0.0);
+    register_property<OrbitSystem2D, bool>("kepler_table_enabled", &OrbitSystem2D::set_kepler_table_enabled, &OrbitSystem2D::get_kepler_table_enabled, false);
+    register_property<OrbitSystem2D, bool>("kepler_table_refine", &OrbitSystem2D::set_kepler_table_refine, &OrbitSystem2D::get_kepler_table_refine, false);
+    register_property<OrbitSystem2D, float>("kepler_table_tolerance", &OrbitSystem2D::set_kepler_table_tolerance, &OrbitSystem2D::get_kepler_table_tolerance, 1e-6);
+    register_property<OrbitSystem2D, int>("kepler_table_memory_budget", &OrbitSystem2D::set_kepler_table_memory_budget, &OrbitSystem2D::get_kepler_table_memory_budget, 16 << 20);
+    register_property<OrbitSystem2D, bool>("event_driven", &OrbitSystem2D::set_event_driven, &OrbitSystem2D::get_event_driven, false);
+    register_property<OrbitSystem2D, float>("soi_radius", &OrbitSystem2D::set_soi_radius, &OrbitSystem2D::get_soi_radius, 0.0);
+    register_property<OrbitSystem2D, float>("event_horizon", &OrbitSystem2D::set_event_horizon, &OrbitSystem2D::get_event_horizon, 10.0);
+    register_property<OrbitSystem2D, float>("integrator_step_fraction", &OrbitSystem2D::set_integrator_step_fraction, &OrbitSystem2D::get_integrator_step_fraction, 0.01);
+    register_property<OrbitSystem2D, float>("nbody_opening_angle", &OrbitSystem2D::set_nbody_opening_angle, &OrbitSystem2D::get_nbody_opening_angle, 0.5);
+    register_property<OrbitSystem2D, float>("nbody_softening", &OrbitSystem2D::set_nbody_softening, &OrbitSystem2D::get_nbody_softening, 0.0);
+
+    register_signal<OrbitSystem2D>((char *)"orbit_event", "body", GODOT_VARIANT_TYPE_INT, "type", GODOT_VARIANT_TYPE_INT, "other", GODOT_VARIANT_TYPE_INT, "time", GODOT_VARIANT_TYPE_REAL);
+}
+
+OrbitSystem2D::OrbitSystem2D() {}
+OrbitSystem2D::~OrbitSystem2D() {}
+
+// Godot functions
+void OrbitSystem2D::_init() {
+    time_scale = 1.0;
+    event_driven = false;
+    _results_dirty = true;
+}
+
+void OrbitSystem2D::_physics_process(float delta) {
+    stats::flush_frame(Engine::get_singleton()->get_idle_frames());
+    if (event_driven) {
+        advance(delta * time_scale);
+        return;
+    }
+    _system.set_time(_system.get_time() + delta * time_scale);
+    propagate();
+}
+
+void OrbitSystem2D::_update_results() {
+    if (!_results_dirty) return;
+    const std::vector<Vector2> &positions = _system.get_positions();
+    const std::vector<Vector2> &velocities = _system.get_velocities();
+    const int count = static_cast<int>(positions.size());
+    _positions.resize(count);
+    _velocities.resize(count);
+    PoolVector2Array::Write p = _positions.write();
+    PoolVector2Array::Write v = _velocities.write();
+    std::copy(positions.begin(), positions.end(), p.ptr());
+    std::copy(velocities.begin(), velocities.end(), v.ptr());
+    _results_dirty = false;
+}
+
+// Important Functions
+void OrbitSystem2D::propagate() {
+    _system.propagate();
+    _results_dirty = true;
+}
+
+void OrbitSystem2D::advance(const float delta) {
+    // Handlers run inside the event loop and may change the bodies, the system picks the schedule up after them
+    _system.advance(delta, [this](const orbits::OrbitEvent &event) {
+        emit_signal("orbit_event", event.body, event.type, event.other, event.time);
+    });
+    _results_dirty = true;
+}
+
+int OrbitSystem2D::add_body(const float eccentricity, const float semi_major_axis,
+                            const float argument_of_periapsis, const float time_offset) {
+    // time_offset is the time since periapsis passage at time 0, i.e. the body was at periapsis at -time_offset
+    return add_body_at_epoch(eccentricity, semi_major_axis, argument_of_periapsis, -time_offset, 0.0);
+}
+
+int OrbitSystem2D::add_body_at_epoch(const float eccentricity, const float semi_major_axis,
+                                     const float argument_of_periapsis, const double epoch,
+                                     const double mean_anomaly_at_epoch) {
+    ERR_FAIL_COND_V(!orbits::OrbitSystem::is_valid_orbit(eccentricity, semi_major_axis), -1);
+    return _system.add_body(eccentricity, semi_major_axis, argument_of_periapsis, epoch, mean_anomaly_at_epoch);
+}
+
+void OrbitSystem2D::set_body(const int index, const float eccentricity, const float semi_major_axis,
+                             const float argument_of_periapsis, const float time_offset) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    ERR_FAIL_COND(!_system.set_body(index, eccentricity, semi_major_axis, argument_of_periapsis, -time_offset, 0.0));
+}
+
+void OrbitSystem2D::remove_body(const int index) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.remove_body(index);
+}
+
+void OrbitSystem2D::clear_bodies() {
+    _system.clear_bodies();
+}
+
+int OrbitSystem2D::get_body_count() {
+    return _system.get_body_count();
+}
+
+void OrbitSystem2D::set_body_radius(const int index, const float radius) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_radius(index, radius);
+}
+
+float OrbitSystem2D::get_body_radius(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), 0.0);
+    return _system.get_body_radius(index);
+}
+
+void OrbitSystem2D::set_body_visible(const int index, const bool visible) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_visible(index, visible);
+}
+
+bool OrbitSystem2D::is_body_visible(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), false);
+    return _system.is_body_visible(index);
+}
+
+int OrbitSystem2D::get_pending_event_count() {
+    return _system.get_pending_event_count();
+}
+
+void OrbitSystem2D::set_body_parent(const int index, const int parent) {
+    const int count = _system.get_body_count();
+    ERR_FAIL_INDEX(index, count);
+    ERR_FAIL_COND(parent < -1 || parent >= count);
+    // A body cannot orbit itself or one of its own satellites
+    ERR_FAIL_COND(!_system.set_body_parent(index, parent));
+}
+
+int OrbitSystem2D::get_body_parent(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), -1);
+    return _system.get_body_parent(index);
+}
+
+void OrbitSystem2D::set_body_standard_gravitational_parameter(const int index, const float value) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_standard_gravitational_parameter(index, value);
+}
+
+float OrbitSystem2D::get_body_standard_gravitational_parameter(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), 0.0);
+    return _system.get_body_standard_gravitational_parameter(index);
+}
+
+void OrbitSystem2D::set_body_thrust(const int index, const Vector2 acceleration) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_thrust(index, acceleration);
+}
+
+Vector2 OrbitSystem2D::get_body_thrust(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), Vector2());
+    return _system.get_body_thrust(index);
+}
+
+bool OrbitSystem2D::is_body_off_rails(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), false);
+    return _system.is_body_off_rails(index);
+}
+
+void OrbitSystem2D::set_body_state(const int index, const Vector2 position, const Vector2 velocity) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_state(index, position, velocity);
+}
+
+void OrbitSystem2D::set_body_perturbed(const int index, const bool perturbed) {
+    ERR_FAIL_INDEX(index, _system.get_body_count());
+    _system.set_body_perturbed(index, perturbed);
+}
+
+bool OrbitSystem2D::is_body_perturbed(const int index) {
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), false);
+    return _system.is_body_perturbed(index);
+}
+
+PoolVector2Array OrbitSystem2D::get_foci() {
+    // Focus of every body's orbit as of the last propagation
+    const int count = _system.get_body_count();
+    PoolVector2Array result;
+    result.resize(count);
+    if (!_system.is_propagated()) return result;
+    PoolVector2Array::Write foci = result.write();
+    for (int i = 0; i < count; i++) {
+        foci[i] = _system.get_focus(i);
+    }
+    return result;
+}
+
+int OrbitSystem2D::find_soi(const Vector2 point) {
+    return _system.find_soi(point);
+}
+
+PoolIntArray OrbitSystem2D::find_sois(const PoolVector2Array points) {
+    PoolIntArray result;
+    result.resize(points.size());
+    _system.find_soi_batch(points.size(), points.read().ptr(), result.write().ptr());
+    return result;
+}
+
+PoolIntArray OrbitSystem2D::update_soi_transitions() {
+    std::vector<int> transitions;
+    _system.update_soi_transitions(transitions);
+    PoolIntArray result;
+    result.resize(static_cast<int>(transitions.size()));
+    PoolIntArray::Write write = result.write();
+    for (int k = 0; k < static_cast<int>(transitions.size()); k++) {
+        write[k] = transitions[k];
+    }
+    return result;
+}
+
+PoolIntArray OrbitSystem2D::get_intercepting_body_pairs() {
+    std::vector<std::pair<int, int>> pairs;
+    _system.find_intercepting_pairs(pairs);
+
+    // Flattened as [i0, j0, i1, j1, ...]
+    PoolIntArray result;
+    result.resize(2 * static_cast<int>(pairs.size()));
+    PoolIntArray::Write write = result.write();
+    for (int k = 0; k < static_cast<int>(pairs.size()); k++) {
+        write[2 * k] = pairs[k].first;
+        write[2 * k + 1] = pairs[k].second;
+    }
+    return result;
+}
+
+PoolVector2Array OrbitSystem2D::get_intercept_points(const int index1, const int index2) {
+    PoolVector2Array result;
+    ERR_FAIL_INDEX_V(index1, _system.get_body_count(), result);
+    ERR_FAIL_INDEX_V(index2, _system.get_body_count(), result);
+    ERR_FAIL_COND_V(_system.get_body_parent(index1) != _system.get_body_parent(index2), result);
+    Vector2 points[4];
+    const int count = _system.find_intercept_points(index1, index2, points);
+    result.resize(count);
+    PoolVector2Array::Write write = result.write();
+    for (int k = 0; k < count; k++) {
+        write[k] = points[k];
+    }
+    return result;
+}
+
+PoolRealArray OrbitSystem2D::get_next_overlap_times(const PoolIntArray pairs, const PoolRealArray radii,
+                                                   const float duration) {
+    PoolRealArray result;
+    const int count = _system.get_body_count();
+    ERR_FAIL_COND_V(radii.size() != count, result);
+    ERR_FAIL_COND_V(pairs.size() % 2 != 0, result);
+    PoolIntArray::Read pair_indices = pairs.read();
+    for (int k = 0; k < pairs.size(); k++) {
+        ERR_FAIL_INDEX_V(pair_indices[k], count, result);
+    }
+    for (int k = 0; k < pairs.size(); k += 2) {
+        ERR_FAIL_COND_V(_system.get_body_parent(pair_indices[k]) != _system.get_body_parent(pair_indices[k + 1]),
+                        result);
+    }
+
+    // Times are reported on the system clock, infinity for pairs that do not touch before time + duration
+    const int pair_count = pairs.size() / 2;
+    std::vector<double> times(pair_count);
+    _system.find_next_overlap_times(pair_count, pair_indices.ptr(), radii.read().ptr(), duration, times.data());
+
+    result.resize(pair_count);
+    PoolRealArray::Write write = result.write();
+    for (int k = 0; k < pair_count; k++) {
+        write[k] = times[k];
+    }
+    return result;
+}
+
+PoolVector2Array OrbitSystem2D::get_transfer_velocities(const int focus, const Vector2 from, const Vector2 to,
+                                                       const float time_of_flight) {
+    // Positions and velocities are relative to focus, -1 for the primary at the origin. Empty without a transfer.
+    PoolVector2Array result;
+    ERR_FAIL_COND_V(focus < -1 || focus >= _system.get_body_count(), result);
+    Vector2 departure_velocity, arrival_velocity;
+    if (!_system.get_transfer_velocities(focus, from, to, time_of_flight, departure_velocity, arrival_velocity)) {
+        return result;
+    }
+    result.append(departure_velocity);
+    result.append(arrival_velocity);
+    return result;
+}
+
+PoolRealArray OrbitSystem2D::get_porkchop_plot(const int departure_body, const int arrival_body,
+                                              const double departure_start, const double departure_end,
+                                              const int departure_count, const double arrival_start,
+                                              const double arrival_end, const int arrival_count,
+                                              const int coarse_stride) {
+    PoolRealArray result;
+    ERR_FAIL_INDEX_V(departure_body, _system.get_body_count(), result);
+    ERR_FAIL_INDEX_V(arrival_body, _system.get_body_count(), result);
+    ERR_FAIL_COND_V(_system.get_body_parent(departure_body) != _system.get_body_parent(arrival_body), result);
+    ERR_FAIL_COND_V(departure_count <= 0 || arrival_count <= 0, result);
+
+    // departure_count rows of arrival_count delta-v values, times spread evenly over both ranges inclusive
+    const double departure_step = departure_count > 1 ? (departure_end - departure_start) / (departure_count - 1) : 0.0;
+    const double arrival_step = arrival_count > 1 ? (arrival_end - arrival_start) / (arrival_count - 1) : 0.0;
+    result.resize(departure_count * arrival_count);
+    PoolRealArray::Write write = result.write();
+    _system.get_porkchop_plot(departure_body, arrival_body, departure_start, departure_step, departure_count,
+                              arrival_start, arrival_step, arrival_count, coarse_stride, write.ptr());
+    return result;
+}
+
+PoolRealArray OrbitSystem2D::get_nearest_points(const int index, const PoolVector2Array points) {
+    // Per point: the closest point of the orbit (x, y), the distance to it, its eccentric and true anomaly and the
+    // time the body takes to get there, against the orbit as of the last propagation
+    PoolRealArray result;
+    ERR_FAIL_INDEX_V(index, _system.get_body_count(), result);
+    ERR_FAIL_COND_V(_system.is_body_off_rails(index), result);
+    std::vector<orbits::NearestPoint> nearest(points.size());
+    if (!_system.get_nearest_points(index, points.size(), points.read().ptr(), nearest.data())) return result;
+    result.resize(points.size() * nearest_stride);
+    PoolRealArray::Write write = result.write();
+    for (int k = 0; k < points.size(); k++) {
+        real_t *out = write.ptr() + k * nearest_stride;
+        out[0] = nearest[k].point.x;
+        out[1] = nearest[k].point.y;
+        out[2] = nearest[k].distance;
+        out[3] = nearest[k].eccentric_anomaly;
+        out[4] = nearest[k].true_anomaly;
+        out[5] = nearest[k].time_of_flight;
+    }
+    return result;
+}
+
+int OrbitSystem2D::find_nearest_body(const Vector2 point, const float max_distance) {
+    return _system.find_nearest_body(point, max_distance);
+}
+
+int OrbitSystem2D::get_kepler_table_count() {
+    return _system.get_kepler_table_count();
+}
+
+int OrbitSystem2D::get_kepler_table_memory_usage() {
+    return static_cast<int>(_system.get_kepler_table_memory_usage());
+}
+
+// Setters
+void OrbitSystem2D::set_standard_gravitational_parameter(const float value) {
+    _system.set_standard_gravitational_parameter(value);
+}
+void OrbitSystem2D::set_time_scale(const float value) {
+    time_scale = value;
+}
+void OrbitSystem2D::set_time(const double value) {
+    _system.set_time(value);
+}
+void OrbitSystem2D::set_kepler_table_enabled(const bool value) {
+    _system.set_kepler_table_enabled(value);
+}
+void OrbitSystem2D::set_kepler_table_refine(const bool value) {
+    _system.set_kepler_table_refine(value);
+}
+void OrbitSystem2D::set_kepler_table_tolerance(const float value) {
+    _system.set_kepler_table_tolerance(value);
+}
+void OrbitSystem2D::set_kepler_table_memory_budget(const int value) {
+    _system.set_kepler_table_memory_budget(value);
+}
+void OrbitSystem2D::set_event_driven(const bool value) {
+    event_driven = value;
+    // Events are not kept up to date while the system propagates every frame
+    _system.reset_events();
+}
+void OrbitSystem2D::set_soi_radius(const float value) {
+    _system.set_soi_radius(value);
+}
+void OrbitSystem2D::set_integrator_step_fraction(const float value) {
+    ERR_FAIL_COND(value <= 0.0);
+    _system.set_integrator_step_fraction(value);
+}
+void OrbitSystem2D::set_nbody_opening_angle(const float value) {
+    ERR_FAIL_COND(value < 0.0);
+    _system.set_nbody_opening_angle(value);
+}
+void OrbitSystem2D::set_nbody_softening(const float value) {
+    ERR_FAIL_COND(value < 0.0);
+    _system.set_nbody_softening(value);
+}
+void OrbitSystem2D::set_event_horizon(const float value) {
+    _system.set_event_horizon(value);
+}
+
+// Getters
+float OrbitSystem2D::get_standard_gravitational_parameter() {return _system.get_standard_gravitational_parameter();}
+float OrbitSystem2D::get_time_scale() {return time_scale;}
+double OrbitSystem2D::get_time() {return _system.get_time();}
+bool OrbitSystem2D::get_kepler_table_enabled() {return _system.get_kepler_table_enabled();}
+bool OrbitSystem2D::get_kepler_table_refine() {return _system.get_kepler_table_refine();}
+float OrbitSystem2D::get_kepler_table_tolerance() {return _system.get_kepler_table_tolerance();}
+int OrbitSystem2D::get_kepler_table_memory_budget() {return _system.get_kepler_table_memory_budget();}
+bool OrbitSystem2D::get_event_driven() {return event_driven;}
+float OrbitSystem2D::get_soi_radius() {return _system.get_soi_radius();}
+float OrbitSystem2D::get_event_horizon() {return _system.get_event_horizon();}
+float OrbitSystem2D::get_integrator_step_fraction() {return _system.get_integrator_step_fraction();}
+float OrbitSystem2D::get_nbody_opening_angle() {return _system.get_nbody_opening_angle();}
+float OrbitSystem2D::get_nbody_softening() {return _system.get_nbody_softening();}
+PoolVector2Array OrbitSystem2D::get_positions() {
+    _update_results();
+    return _positions;
+}
+PoolVector2Array OrbitSystem2D::get_velocities() {
+    _update_results();
+    return _velocities;
+}
@@ -0,0 +1,216 @@
+#ifndef __ORBITSYSTEM2D_H_
+#define __ORBITSYSTEM2D_H_
+
+#include <Godot.hpp>
+#include <Node2D.hpp>
+
+#include "orbit_system.hpp"
+
+namespace godot {
+
+/**
+Owns many bodies orbiting a single primary at the node's origin and propagates all of them every physics frame.
+Propagation is split across the shared work-stealing job pool, so the body count scales with the core count
+instead of being bound to the main thread like one OrbitPath2D per body.
+
+With event_driven enabled the system jumps between the events of its bodies instead of propagating all of them
+every frame. It emits orbit_event(body, type, other, time) for every periapsis passage, exit from soi_radius and
+contact between bodies with a radius, in time order, and only propagates visible bodies and bodies that had an
+event. The event types are the values of orbits::OrbitEventType: 0 periapsis, 1 SOI exit, 2 collision.
+
+A body can orbit another body of the system instead of the origin, see set_body_parent. Its focus then follows
+the parent's analytic position, so moons of planets of a star need no nested nodes.
+
+Every body with a standard gravitational parameter of its own has a sphere of influence of a (m / M)^(2/5) around
+it. The spheres follow their bodies in a grid updated on every propagation, so find_sois can place thousands of
+points at once, and update_soi_transitions hands massless bodies such as ships over to the body whose sphere they
+entered or back to the one they left.
+
+A body under thrust, see set_body_thrust, leaves its elements and is integrated with leapfrog around its primary
+instead. Once the thrust stops it is fitted to the orbit it ended up on and goes back to the closed form path, so
+only bodies that are actually manoeuvring cost integration steps.
+
+set_body_state places a body at a position and velocity relative to its primary. A body left on an orbit the
+elements cannot describe, an escape trajectory or a parabolic or clockwise pass, stays off rails and coasts along
+its conic in closed form through the universal variable kernel, so flybys cost no integration steps either.
+
+Bodies marked with set_body_perturbed are integrated the same way and also feel the gravity of every body with a
+standard gravitational parameter, summed through a Barnes-Hut tree rebuilt on every step, for clusters and debris
+fields the single focus model cannot describe. nbody_opening_angle trades accuracy for speed, 0 sums directly.
+
+get_nearest_points snaps points onto the orbit of a body, with the anomalies of the snapped points and the time
+the body takes to get there, and find_nearest_body picks the orbit passing closest to a point, for hover picking
+and placing manoeuvre nodes.
+
+The bodies and everything computed from them live in an orbits::OrbitSystem, this node only converts arguments,
+reports errors and emits the events.
+*/
+class OrbitSystem2D : public Node2D {
+    GODOT_CLASS(OrbitSystem2D, Node2D
+    )
+
+private:
+    // User Defined
+    float time_scale;
+    bool event_driven;
+
+    orbits::OrbitSystem _system;
+
+    // Results of the last propagation, copied out of the system when they are first asked for
+    PoolVector2Array _positions;
+    PoolVector2Array _velocities;
+    bool _results_dirty;
+
+    void _update_results();
+
+public:
+    static void _register_methods();
+
+    OrbitSystem2D();
+
+    ~OrbitSystem2D();
+
+    void _init();
+    void _physics_process(float delta);
+
+    // Important Functions
+    void propagate();
+
+    void advance(const float delta);
+
+    int add_body(const float eccentricity, const float semi_major_axis, const float argument_of_periapsis,
+                 const float time_offset);
+
+    int add_body_at_epoch(const float eccentricity, const float semi_major_axis, const float argument_of_periapsis,
+                          const double epoch, const double mean_anomaly_at_epoch);
+
+    void set_body(const int index, const float eccentricity, const float semi_major_axis,
+                  const float argument_of_periapsis, const float time_offset);
+
+    void remove_body(const int index);
+
+    void clear_bodies();
+
+    void set_body_radius(const int index, const float radius);
+
+    float get_body_radius(const int index);
+
+    void set_body_visible(const int index, const bool visible);
+
+    bool is_body_visible(const int index);
+
+    int get_pending_event_count();
+
+    void set_body_parent(const int index, const int parent);
+
+    int get_body_parent(const int index);
+
+    void set_body_standard_gravitational_parameter(const int index, const float value);
+
+    float get_body_standard_gravitational_parameter(const int index);
+
+    void set_body_thrust(const int index, const Vector2 acceleration);
+
+    Vector2 get_body_thrust(const int index);
+
+    bool is_body_off_rails(const int index);
+
+    void set_body_state(const int index, const Vector2 position, const Vector2 velocity);
+
+    void set_body_perturbed(const int index, const bool perturbed);
+
+    bool is_body_perturbed(const int index);
+
+    PoolVector2Array get_foci();
+
+    int find_soi(const Vector2 point);
+
+    PoolIntArray find_sois(const PoolVector2Array points);
+
+    PoolIntArray update_soi_transitions();
+
+    int get_body_count();
+
+    PoolIntArray get_intercepting_body_pairs();
+
+    PoolVector2Array get_intercept_points(const int index1, const int index2);
+
+    PoolRealArray get_next_overlap_times(const PoolIntArray pairs, const PoolRealArray radii, const float duration);
+
+    PoolVector2Array get_transfer_velocities(const int focus, const Vector2 from, const Vector2 to,
+                                             const float time_of_flight);
+
+    PoolRealArray get_porkchop_plot(const int departure_body, const int arrival_body, const double departure_start,
+                                    const double departure_end, const int departure_count, const double arrival_start,
+                                    const double arrival_end, const int arrival_count, const int coarse_stride);
+
+    PoolRealArray get_nearest_points(const int index, const PoolVector2Array points);
+
+    int find_nearest_body(const Vector2 point, const float max_distance);
+
+    int get_kepler_table_count();
+
+    int get_kepler_table_memory_usage();
+
+    // Setters
+    void set_standard_gravitational_parameter(const float value);
+
+    void set_time_scale(const float value);
+
+    void set_time(const double value);
+
+    void set_kepler_table_enabled(const bool value);
+
+    void set_kepler_table_refine(const bool value);
+
+    void set_kepler_table_tolerance(const float value);
+
+    void set_kepler_table_memory_budget(const int value);
+
+    void set_event_driven(const bool value);
+
+    void set_soi_radius(const float value);
+
+    void set_event_horizon(const float value);
+
+    void set_integrator_step_fraction(const float value);
+
+    void set_nbody_opening_angle(const float value);
+
+    void set_nbody_softening(const float value);
+
+    // Getters
+    float get_standard_gravitational_parameter();
+
+    float get_time_scale();
+
+    double get_time();
+
+    bool get_kepler_table_enabled();
+
+    bool get_kepler_table_refine();
+
+    float get_kepler_table_tolerance();
+
+    int get_kepler_table_memory_budget();
+
+    bool get_event_driven();
+
+    float get_soi_radius();
+
+    float get_event_horizon();
+
+    float get_integrator_step_fraction();
+
+    float get_nbody_opening_angle();
+
+    float get_nbody_softening();
+
+    PoolVector2Array get_positions();
+
+    PoolVector2Array get_velocities();
+};
+
+}
+
+#endif // __ORBITSYSTEM2D_H_
@@ -1,4 +1,8 @@
 #include "OrbitPath2D.hpp"
+#include "OrbitPathBatch2D.hpp"
+#include "OrbitPathFollow2D.hpp"
+#include "OrbitServer.hpp"
+#include "OrbitSystem2D.hpp"
 
 extern "C" void GDN_EXPORT godot_gdnative_init(godot_gdnative_init_options *o) {
     godot::Godot::gdnative_init(o);
@@ -12,4 +16,8 @@ extern "C" void GDN_EXPORT godot_nativescript_init(void *handle) {
     godot::Godot::nativescript_init(handle);
 
     godot::register_class<godot::OrbitPath2D>();
+    godot::register_class<godot::OrbitPathBatch2D>();
+    godot::register_class<godot::OrbitPathFollow2D>();
+    godot::register_class<godot::OrbitServer>();
+    godot::register_class<godot::OrbitSystem2D>();
 }
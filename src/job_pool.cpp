@@ -0,0 +1,120 @@
+#include "job_pool.hpp"
+
+namespace jobs {
+
+    namespace {
+        // Queue index of the pool worker running on this thread, -1 for threads outside any pool
+        thread_local int worker_index = -1;
+        thread_local const JobPool *worker_pool = nullptr;
+    }
+
+    JobPool::JobPool(int thread_count) : queued(0), stopping(false) {
+        if (thread_count <= 0) {
+            const int cores = static_cast<int>(std::thread::hardware_concurrency());
+            thread_count = cores > 1 ? cores - 1 : 0;
+        }
+        queue_count = thread_count + 1;
+        queues.reset(new Queue[queue_count]);
+        threads.reserve(thread_count);
+        for (int i = 0; i < thread_count; i++) {
+            threads.emplace_back(&JobPool::worker_loop, this, i);
+        }
+    }
+
+    JobPool::~JobPool() {
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+    }
+
+    int JobPool::get_thread_count() const {
+        return static_cast<int>(threads.size());
+    }
+
+    JobPool &JobPool::get_singleton() {
+        static JobPool pool;
+        return pool;
+    }
+
+    void JobPool::parallel_for(const int count, const int grain_size, const std::function<void(int, int)> &fn) {
+        if (count <= 0) return;
+        const int grain = grain_size > 0 ? grain_size : 1;
+        if (threads.empty() || count <= grain) {
+            fn(0, count);
+            return;
+        }
+
+        const int self = worker_pool == this ? worker_index : queue_count - 1;
+        const int task_count = (count + grain - 1) / grain;
+        std::atomic<int> pending(task_count);
+
+        // Deal the ranges out round-robin, starting with our own queue so we begin on local work
+        for (int i = 0; i < task_count; i++) {
+            const int begin = i * grain;
+            const int end = begin + grain < count ? begin + grain : count;
+            Queue &queue = queues[(self + i) % queue_count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.tasks.push_back(Task{&fn, begin, end, &pending});
+        }
+        {
+            std::lock_guard<std::mutex> lock(wake_mutex);
+            queued += task_count;
+        }
+        wake.notify_all();
+
+        while (pending.load(std::memory_order_acquire) > 0) {
+            if (!run_one(self)) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobPool::worker_loop(const int index) {
+        worker_index = index;
+        worker_pool = this;
+        while (true) {
+            if (run_one(index)) continue;
+
+            std::unique_lock<std::mutex> lock(wake_mutex);
+            wake.wait(lock, [this] { return stopping || queued.load() > 0; });
+            if (stopping && queued.load() == 0) return;
+        }
+    }
+
+    bool JobPool::run_one(const int index) {
+        Task task;
+        if (!pop(index, task) && !steal(index, task)) return false;
+
+        queued.fetch_sub(1);
+        (*task.fn)(task.begin, task.end);
+        task.pending->fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    bool JobPool::pop(const int index, Task &task) {
+        Queue &queue = queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) return false;
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+        return true;
+    }
+
+    bool JobPool::steal(const int thief, Task &task) {
+        for (int i = 1; i < queue_count; i++) {
+            Queue &queue = queues[(thief + i) % queue_count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (queue.tasks.empty()) continue;
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+            return true;
+        }
+        return false;
+    }
+
+}
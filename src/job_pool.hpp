@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace jobs {
+
+    /**
+    A work-stealing thread pool for data parallel loops.
+    Every worker owns a task queue, pops its own work from the back and steals from the front of the other
+    queues once its own is empty, so uneven chunks (e.g. highly eccentric orbits that need more Kepler
+    iterations) balance out without a central queue.
+    */
+    class JobPool {
+    public:
+        /**
+        @param thread_count number of worker threads, 0 picks one less than the core count since the calling
+               thread also runs tasks while it waits
+        */
+        explicit JobPool(int thread_count = 0);
+
+        ~JobPool();
+
+        JobPool(const JobPool &) = delete;
+
+        JobPool &operator=(const JobPool &) = delete;
+
+        /**
+        Calls fn(begin, end) for consecutive ranges of at most grain_size indices covering [0, count) and blocks
+        until every range has been processed. The calling thread helps run the ranges.
+        May be called from inside a task.
+
+        @param count number of indices
+        @param grain_size largest range handed to a single call of fn
+        @param fn the loop body, invoked concurrently from several threads
+        */
+        void parallel_for(const int count, const int grain_size, const std::function<void(int, int)> &fn);
+
+        int get_thread_count() const;
+
+        /**
+        Shared pool sized to the machine, created on first use.
+        */
+        static JobPool &get_singleton();
+
+    private:
+        struct Task {
+            const std::function<void(int, int)> *fn;
+            int begin;
+            int end;
+            std::atomic<int> *pending;
+        };
+
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        void worker_loop(const int index);
+
+        bool run_one(const int index);
+
+        bool pop(const int index, Task &task);
+
+        bool steal(const int thief, Task &task);
+
+        std::vector<std::thread> threads;
+        // One queue per worker plus a shared one for threads outside the pool
+        std::unique_ptr<Queue[]> queues;
+        int queue_count;
+
+        std::mutex wake_mutex;
+        std::condition_variable wake;
+        std::atomic<int> queued;
+        bool stopping;
+    };
+
+}
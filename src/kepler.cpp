@@ -1,5 +1,7 @@
 #include <cmath>
 
+#include "kepler.hpp"
+
 namespace kepler {
 
     /**
@@ -11,13 +13,9 @@ namespace kepler {
     @return starting value for the eccentric anomaly.
     */
     double keplerstart3(double e, double M) {
-        double t34 = e * e;
-        double t35 = e * t34;
-        double t33 = std::cos(M);
-        return M + (-0.5 * t35 + e + (t34 + 1.5 * t33 * t35) * t33) * std::sin(M);
+        return keplerstart3<double>(e, M);
     }
 
-
     /**
     An iteration (correction) method to solve Kepler's equation.
     See "A Practical Method for Solving the Kepler Equation", Marc A. Murison, 2006
@@ -28,14 +26,7 @@ namespace kepler {
     @return corrected value for the eccentric anomaly
     */
     double eps3(const double e, const double M, const double x) {
-        double t1 = std::cos(x);
-        double t2 = -1 + e * t1;
-        double t3 = std::sin(x);
-        double t4 = e * t3;
-        double t5 = -x + t4 + M;
-        double t6 = t5 / (0.5 * t5 * t4 / t2 + t2);
-
-        return t5 / ((0.5 * t3 - 1 / 6 * t1 * t6) * e * t6 + t2);
+        return eps3<double>(e, M, x);
     }
 
     /**
@@ -51,23 +42,232 @@ namespace kepler {
     @return eccentric anomaly.
     */
     double ecc_anomaly(const double ecc, const double mean_anomaly) {
-        double tol;
-        if (ecc < 0.8) tol = 1e-14;
-        else tol = 1e-13;
+        return ecc_anomaly<double>(ecc, mean_anomaly);
+    }
+
+    /**
+    Same as ecc_anomaly, also reporting the number of eps3 corrections it took.
+
+    @param ecc the eccentricity of the orbit
+    @param mean_anomaly mean anomaly (in radians)
+    @param iterations output, number of corrections applied, 100 when the solver failed to converge
+    @return eccentric anomaly.
+    */
+    double ecc_anomaly(const double ecc, const double mean_anomaly, int &iterations) {
+        return ecc_anomaly<double>(ecc, mean_anomaly, iterations);
+    }
+
+    /**
+    Solves Kepler's equation starting from a nearby eccentric anomaly instead of keplerstart3.
+    Meant for bodies stepped forward every frame, where the previous solution is off by only the small change in
+    mean anomaly and one or two eps3 corrections reach full precision.
 
-        double Mnorm = std::fmod(mean_anomaly, 2.0 * M_PI);
-        double E0 = keplerstart3(ecc, Mnorm);
+    @param ecc the eccentricity of the orbit
+    @param mean_anomaly mean anomaly (in radians), not reduced, so it stays on the same branch as the guess
+    @param guess eccentric anomaly to start from, usually the previous frame's solution
+    @return eccentric anomaly.
+    */
+    double ecc_anomaly_from_guess(const double ecc, const double mean_anomaly, const double guess) {
+        const double tol = SolverTraits<double>::tolerance(ecc);
+
+        double E0 = guess;
+        double E = guess;
         double dE = tol + 1;
-        double E;
         int count = 0;
         while (dE > tol) {
-            E = E0 - eps3(ecc, Mnorm, E0);
+            E = E0 - eps3(ecc, mean_anomaly, E0);
             dE = std::abs(E - E0);
             E0 = E;
             count++;
-            // failed to converge, this only happens for nearly parabolic orbits
-            if (count == 100) break;
+            // a guess far outside the basin of convergence, fall back to a cold start
+            if (count == SolverTraits<double>::max_iterations) return ecc_anomaly(ecc, mean_anomaly);
         }
+        stats::add_kepler_solve(count, true);
         return E;
     }
+
+    // Vectorized solver
+    //
+    // The lane kernels below are written as plain loops over small fixed size arrays with no data dependent
+    // branches, so the compiler turns every loop into packed SSE2 or AVX2 instructions. std::sin and std::cos
+    // would force a scalar libm call per lane, so they are replaced by a branch free sin/cos pair.
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define KEPLER_INLINE inline __attribute__((always_inline))
+#define KEPLER_DISPATCH_AVX2
+#else
+#define KEPLER_INLINE inline
+#endif
+
+    namespace {
+        const int lanes = 8;
+        const int simd_max_iterations = 8;
+
+        // Adding and subtracting 1.5 * 2^52 rounds a double to the nearest integer without a libm call
+        const double round_magic = 6755399441055744.0;
+
+        // pi / 2 split in two so that q * pio2_hi is exact for the quadrants seen here (Cody-Waite reduction)
+        const double pio2_hi = 1.57079632673412561417e+00;
+        const double pio2_lo = 6.07710050650619224932e-11;
+
+        /**
+        Branch free sine and cosine, accurate to a few ulp for the arguments the solver produces.
+        Reduces x to r in [-pi/4, pi/4] and a quadrant, then evaluates Taylor polynomials in r.
+        */
+        KEPLER_INLINE void sin_cos(const double x, double &s, double &c) {
+            const double q = (x * M_2_PI + round_magic) - round_magic;
+            const int quadrant = static_cast<int>(q);
+            const double r = (x - q * pio2_hi) - q * pio2_lo;
+            const double r2 = r * r;
+
+            const double sin_r = r + r * r2 * (-1.0 / 6.0 + r2 * (1.0 / 120.0 + r2 * (-1.0 / 5040.0 + r2 * (
+                    1.0 / 362880.0 + r2 * (-1.0 / 39916800.0 + r2 * (1.0 / 6227020800.0 + r2 * (
+                    -1.0 / 1307674368000.0)))))));
+            const double cos_r = 1.0 + r2 * (-0.5 + r2 * (1.0 / 24.0 + r2 * (-1.0 / 720.0 + r2 * (
+                    1.0 / 40320.0 + r2 * (-1.0 / 3628800.0 + r2 * (1.0 / 479001600.0 + r2 * (
+                    -1.0 / 87178291200.0 + r2 * (1.0 / 20922789888000.0))))))));
+
+            const bool swap = (quadrant & 1) != 0;
+            const double sin_abs = swap ? cos_r : sin_r;
+            const double cos_abs = swap ? sin_r : cos_r;
+            s = (quadrant & 2) != 0 ? -sin_abs : sin_abs;
+            c = ((quadrant + 1) & 2) != 0 ? -cos_abs : cos_abs;
+        }
+
+        /**
+        @param unconverged output, set for every lane still off by more than the tolerance after the last
+               correction
+        @return number of corrections applied, the same for every lane
+        */
+        KEPLER_INLINE int ecc_anomaly_lanes(const double *ecc, const double *mean_anomaly, double *out,
+                                            bool *unconverged) {
+            double e[lanes], M[lanes], E[lanes], dE[lanes];
+
+            for (int i = 0; i < lanes; i++) {
+                // Reduce to [-pi, pi], where keplerstart3 is most accurate
+                const double turns = (mean_anomaly[i] * (0.5 * M_1_PI) + round_magic) - round_magic;
+                e[i] = ecc[i];
+                M[i] = mean_anomaly[i] - turns * 2.0 * M_PI;
+            }
+
+            // keplerstart3
+            for (int i = 0; i < lanes; i++) {
+                double sin_M, cos_M;
+                sin_cos(M[i], sin_M, cos_M);
+                const double t34 = e[i] * e[i];
+                const double t35 = e[i] * t34;
+                E[i] = M[i] + (-0.5 * t35 + e[i] + (t34 + 1.5 * cos_M * t35) * cos_M) * sin_M;
+            }
+
+            // eps3 corrections, every lane runs until the slowest lane of the block has converged
+            int count = 0;
+            while (count < simd_max_iterations) {
+                for (int i = 0; i < lanes; i++) {
+                    double t3, t1;
+                    sin_cos(E[i], t3, t1);
+                    const double t2 = -1.0 + e[i] * t1;
+                    const double t4 = e[i] * t3;
+                    const double t5 = -E[i] + t4 + M[i];
+                    const double t6 = t5 / (0.5 * t5 * t4 / t2 + t2);
+                    dE[i] = t5 / ((0.5 * t3 - 1.0 / 6.0 * t1 * t6) * e[i] * t6 + t2);
+                    E[i] -= dE[i];
+                }
+
+                double max_dE = 0.0;
+                for (int i = 0; i < lanes; i++) {
+                    const double abs_dE = dE[i] < 0.0 ? -dE[i] : dE[i];
+                    max_dE = abs_dE > max_dE ? abs_dE : max_dE;
+                }
+                count++;
+                if (max_dE <= 1e-13) break;
+            }
+
+            for (int i = 0; i < lanes; i++) {
+                out[i] = E[i];
+                unconverged[i] = !((dE[i] < 0.0 ? -dE[i] : dE[i]) <= 1e-13);
+            }
+            return count;
+        }
+
+        /**
+        Solves the valid lanes the block left unconverged again one at a time, with the fallback of the scalar
+        solver. Only nearly parabolic orbits close to periapsis get here.
+
+        @return number of lanes solved again, the scalar solver counts them itself
+        */
+        int resolve_unconverged(const double *ecc, const double *mean_anomaly, double *eccentric_anomaly,
+                                const bool *unconverged, const int valid) {
+            int resolved = 0;
+            for (int j = 0; j < valid; j++) {
+                if (!unconverged[j]) continue;
+                eccentric_anomaly[j] = ecc_anomaly<double>(ecc[j], std::remainder(mean_anomaly[j], 2.0 * M_PI));
+                resolved++;
+            }
+            return resolved;
+        }
+
+        KEPLER_INLINE void ecc_anomaly_batch_kernel(const double *ecc, const double *mean_anomaly,
+                                                    double *eccentric_anomaly, const int count) {
+            // Counted here and handed over once, the lanes themselves stay free of anything but arithmetic
+            uint64_t histogram[stats::kepler_histogram_size] = {};
+            bool unconverged[lanes];
+            int i = 0;
+            for (; i + lanes <= count; i += lanes) {
+                const int iterations = ecc_anomaly_lanes(ecc + i, mean_anomaly + i, eccentric_anomaly + i,
+                                                         unconverged);
+                const int resolved = resolve_unconverged(ecc + i, mean_anomaly + i, eccentric_anomaly + i,
+                                                         unconverged, lanes);
+                histogram[iterations < stats::kepler_histogram_size ? iterations
+                        : stats::kepler_histogram_size - 1] += lanes - resolved;
+            }
+            if (i < count) {
+                // Pad the tail by repeating its last element so the padding cannot slow convergence
+                double e[lanes], M[lanes], E[lanes];
+                for (int j = 0; j < lanes; j++) {
+                    const int k = i + j < count ? i + j : count - 1;
+                    e[j] = ecc[k];
+                    M[j] = mean_anomaly[k];
+                }
+                const int iterations = ecc_anomaly_lanes(e, M, E, unconverged);
+                const int resolved = resolve_unconverged(e, M, E, unconverged, count - i);
+                for (int j = 0; i + j < count; j++) {
+                    eccentric_anomaly[i + j] = E[j];
+                }
+                histogram[iterations < stats::kepler_histogram_size ? iterations
+                        : stats::kepler_histogram_size - 1] += count - i - resolved;
+            }
+            stats::add_kepler_solves(histogram, 0);
+        }
+
+        void ecc_anomaly_batch_generic(const double *ecc, const double *mean_anomaly, double *eccentric_anomaly,
+                                       const int count) {
+            ecc_anomaly_batch_kernel(ecc, mean_anomaly, eccentric_anomaly, count);
+        }
+
+#ifdef KEPLER_DISPATCH_AVX2
+        __attribute__((target("avx2,fma")))
+        void ecc_anomaly_batch_avx2(const double *ecc, const double *mean_anomaly, double *eccentric_anomaly,
+                                    const int count) {
+            ecc_anomaly_batch_kernel(ecc, mean_anomaly, eccentric_anomaly, count);
+        }
+#endif
+
+        typedef void (*ecc_anomaly_batch_fn)(const double *, const double *, double *, const int);
+
+        ecc_anomaly_batch_fn select_ecc_anomaly_batch() {
+#ifdef KEPLER_DISPATCH_AVX2
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                return ecc_anomaly_batch_avx2;
+            }
+#endif
+            return ecc_anomaly_batch_generic;
+        }
+    }
+
+    void ecc_anomaly_batch(const double *ecc, const double *mean_anomaly, double *eccentric_anomaly,
+                           const int count) {
+        static const ecc_anomaly_batch_fn solve = select_ecc_anomaly_batch();
+        solve(ecc, mean_anomaly, eccentric_anomaly, count);
+    }
 }
@@ -1,3 +1,8 @@
+#pragma once
+
+#include <cmath>
+
+#include "stats.hpp"
 
 namespace kepler {
     /**
@@ -14,6 +19,16 @@ namespace kepler {
     */
     double ecc_anomaly(const double ecc, const double mean_anomaly);
 
+    /**
+    Same as ecc_anomaly, also reporting the number of eps3 corrections it took.
+
+    @param ecc the eccentricity of the orbit
+    @param mean_anomaly mean anomaly (in radians)
+    @param iterations output, number of corrections applied, including those of the bracketed fallback
+    @return eccentric anomaly.
+    */
+    double ecc_anomaly(const double ecc, const double mean_anomaly, int &iterations);
+
     /**
     Provides a starting value to solve Kepler's equation.
     See "A Practical Method for Solving the Kepler Equation", Marc A. Murison, 2006
@@ -35,4 +50,165 @@ namespace kepler {
     */
     double eps3(double e, double M, double x);
 
-}
\ No newline at end of file
+    /**
+    Solves Kepler's equation starting from a nearby eccentric anomaly instead of keplerstart3.
+    Meant for bodies stepped forward every frame, where the previous solution is off by only the small change in
+    mean anomaly and one or two eps3 corrections reach full precision.
+
+    @param ecc the eccentricity of the orbit
+    @param mean_anomaly mean anomaly (in radians), not reduced, so it stays on the same branch as the guess
+    @param guess eccentric anomaly to start from, usually the previous frame's solution
+    @return eccentric anomaly.
+    */
+    double ecc_anomaly_from_guess(const double ecc, const double mean_anomaly, const double guess);
+
+    /**
+    Solves Kepler's equation for count bodies at once.
+    Uses the same keplerstart3 + eps3 scheme as ecc_anomaly, evaluated 8 lanes at a time with a lane-masked
+    iteration count instead of a per-body loop. An AVX2 kernel is selected at runtime when the CPU supports it,
+    otherwise the baseline (SSE2 on x86-64) kernel is used. Lanes still unconverged after the last correction are
+    solved again by ecc_anomaly.
+
+    The result is the eccentric anomaly for the mean anomaly reduced to [-pi, pi], so it can differ from
+    ecc_anomaly by a multiple of 2 pi.
+
+    @param ecc the eccentricity of each orbit, must be below 1
+    @param mean_anomaly mean anomaly of each body (in radians)
+    @param eccentric_anomaly output, eccentric anomaly of each body
+    @param count number of bodies
+    */
+    void ecc_anomaly_batch(const double *ecc, const double *mean_anomaly, double *eccentric_anomaly,
+                           const int count);
+
+    // Scalar type generic solver
+    //
+    // The double functions above are the double instantiations of these templates. The float instantiation
+    // trades the tolerance test for a fixed number of corrections, enough to reach float precision, which is all
+    // rendering needs and avoids paying for double convergence that is rounded away on conversion. Near parabolic
+    // orbits the fixed count no longer reaches float precision, or diverges, so those are handed to the double
+    // solver and its convergence test.
+
+    template <typename T>
+    struct SolverTraits;
+
+    template <>
+    struct SolverTraits<double> {
+        static constexpr bool fixed_iterations = false;
+        static constexpr int max_iterations = 100;
+
+        static constexpr double tolerance(const double e) {
+            return e < 0.8 ? 1e-14 : 1e-13;
+        }
+    };
+
+    template <>
+    struct SolverTraits<float> {
+        static constexpr bool fixed_iterations = true;
+        static constexpr int max_iterations = 3;
+
+        // From here on the orbit is solved in double
+        static constexpr float fallback_eccentricity = 0.99f;
+
+        /**
+        Corrections after keplerstart3 that bring every mean anomaly to within float precision of the solution.
+        */
+        static constexpr int iterations(const float e) {
+            return e < 0.95f ? 2 : max_iterations;
+        }
+    };
+
+    template <typename T>
+    inline T keplerstart3(const T e, const T M) {
+        const T t34 = e * e;
+        const T t35 = e * t34;
+        const T t33 = std::cos(M);
+        return M + (T(-0.5) * t35 + e + (t34 + T(1.5) * t33 * t35) * t33) * std::sin(M);
+    }
+
+    template <typename T>
+    inline T eps3(const T e, const T M, const T x) {
+        const T t1 = std::cos(x);
+        const T t2 = T(-1) + e * t1;
+        const T t3 = std::sin(x);
+        const T t4 = e * t3;
+        const T t5 = -x + t4 + M;
+        const T t6 = t5 / (T(0.5) * t5 * t4 / t2 + t2);
+
+        return t5 / ((T(0.5) * t3 - T(1.0 / 6.0) * t1 * t6) * e * t6 + t2);
+    }
+
+    /**
+    Newton's method on Kepler's equation kept inside a bracket of the root, bisecting whenever a step would leave
+    it. E - e sin E - M is increasing and changes sign between M - e and M + e, so this always converges, if slowly,
+    where eps3 from keplerstart3 can diverge: nearly parabolic orbits close to periapsis.
+
+    @param E starting value, replaced by the solution
+    @param count incremented once per step
+    @return true when the step size fell below tol within max_iterations steps
+    */
+    template <typename T>
+    inline bool solve_bracketed(const T e, const T M, const T tol, const int max_iterations, T &E, int &count) {
+        T lo = M - e;
+        T hi = M + e;
+        if (!(E > lo && E < hi)) E = M;
+        for (int i = 0; i < max_iterations; i++) {
+            const T f = E - e * std::sin(E) - M;
+            if (f < 0) lo = E;
+            else hi = E;
+            T next = E - f / (T(1) - e * std::cos(E));
+            if (!(next > lo && next < hi)) next = T(0.5) * (lo + hi);
+            const T step = std::abs(next - E);
+            E = next;
+            count++;
+            if (step <= tol || hi - lo <= tol) return true;
+        }
+        return false;
+    }
+
+    template <typename T>
+    inline T ecc_anomaly(const T ecc, const T mean_anomaly, int &iterations) {
+        typedef SolverTraits<T> traits;
+
+        if constexpr (traits::fixed_iterations) {
+            if (ecc >= traits::fallback_eccentricity) {
+                return static_cast<T>(ecc_anomaly<double>(ecc, mean_anomaly, iterations));
+            }
+        }
+
+        const T Mnorm = std::fmod(mean_anomaly, T(2.0 * M_PI));
+        T E = keplerstart3<T>(ecc, Mnorm);
+        int count = 0;
+        if constexpr (traits::fixed_iterations) {
+            const int n = traits::iterations(ecc);
+            for (; count < n; count++) {
+                E -= eps3<T>(ecc, Mnorm, E);
+            }
+            stats::add_kepler_solve(count, true);
+        } else {
+            const T tol = traits::tolerance(ecc);
+            T dE = tol + 1;
+            while (dE > tol) {
+                const T E0 = E;
+                E = E0 - eps3<T>(ecc, Mnorm, E0);
+                dE = std::abs(E - E0);
+                count++;
+                // diverging or failing to converge, this only happens for nearly parabolic orbits
+                if (!(std::abs(E - Mnorm) <= T(2.0 * M_PI)) || count == traits::max_iterations) break;
+            }
+            bool converged = dE <= tol;
+            if (!converged) {
+                converged = solve_bracketed<T>(ecc, Mnorm, tol, traits::max_iterations, E, count);
+            }
+            stats::add_kepler_solve(count, converged);
+        }
+        iterations = count;
+        return E;
+    }
+
+    template <typename T>
+    inline T ecc_anomaly(const T ecc, const T mean_anomaly) {
+        int iterations;
+        return ecc_anomaly<T>(ecc, mean_anomaly, iterations);
+    }
+
+}
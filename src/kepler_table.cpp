@@ -0,0 +1,132 @@
+#include <cmath>
+
+#include "kepler.hpp"
+#include "kepler_table.hpp"
+
+namespace kepler {
+
+    EccAnomalyTable::EccAnomalyTable(const double ecc, const double tolerance, const int max_intervals)
+            : ecc(ecc), max_error(0.0), interval_scale(0.0) {
+        int interval_count = 64;
+        while (true) {
+            build(interval_count);
+            if (max_error <= tolerance || interval_count * 2 > max_intervals) break;
+            interval_count *= 2;
+        }
+    }
+
+    void EccAnomalyTable::build(const int interval_count) {
+        const double h = 2.0 * M_PI / interval_count;
+        interval_scale = interval_count / (2.0 * M_PI);
+        knots.assign(2 * (interval_count + 1), 0.0);
+        for (int i = 0; i <= interval_count; i++) {
+            // Solve at i * h directly, fmod in ecc_anomaly would fold the last knot back to 0
+            const double E = i == interval_count ? 2.0 * M_PI : ecc_anomaly(ecc, i * h);
+            knots[2 * i] = E;
+            knots[2 * i + 1] = h / (1.0 - ecc * std::cos(E));
+        }
+
+        max_error = 0.0;
+        for (int i = 0; i < interval_count; i++) {
+            const double M = (i + 0.5) * h;
+            const double error = std::abs(get(M, false) - ecc_anomaly(ecc, M));
+            if (error > max_error) max_error = error;
+        }
+    }
+
+    double EccAnomalyTable::get(const double mean_anomaly, const bool refine) const {
+        const double M = mean_anomaly - 2.0 * M_PI * std::floor(mean_anomaly / (2.0 * M_PI));
+        const int last = static_cast<int>(knots.size() / 2) - 2;
+        const double x = M * interval_scale;
+        int i = static_cast<int>(x);
+        if (i > last) i = last;
+        const double t = x - i;
+
+        const double *k = &knots[2 * i];
+        const double E0 = k[0], m0 = k[1], E1 = k[2], m1 = k[3];
+        // Cubic Hermite basis in Horner form
+        const double c1 = m0;
+        const double c2 = 3.0 * (E1 - E0) - 2.0 * m0 - m1;
+        const double c3 = 2.0 * (E0 - E1) + m0 + m1;
+        const double E = E0 + t * (c1 + t * (c2 + t * c3));
+
+        if (!refine) return E;
+        return E - eps3(ecc, M, E);
+    }
+
+    double EccAnomalyTable::get_eccentricity() const {
+        return ecc;
+    }
+
+    double EccAnomalyTable::get_max_error() const {
+        return max_error;
+    }
+
+    int EccAnomalyTable::get_interval_count() const {
+        return static_cast<int>(knots.size() / 2) - 1;
+    }
+
+    std::size_t EccAnomalyTable::get_memory_usage() const {
+        return sizeof(EccAnomalyTable) + knots.capacity() * sizeof(double);
+    }
+
+    EccAnomalyTableCache::EccAnomalyTableCache()
+            : tolerance(1e-6), max_intervals(1 << 16), memory_budget(16 << 20), memory_usage(0) {}
+
+    const EccAnomalyTable *EccAnomalyTableCache::get(const double ecc) {
+        if (!(ecc >= 0.0 && ecc < 1.0)) return nullptr;
+
+        auto found = tables.find(ecc);
+        if (found != tables.end()) return found->second.get();
+
+        // Assume the worst case size so a table is never built only to be thrown away
+        const std::size_t worst_case = sizeof(EccAnomalyTable) + 2 * (max_intervals + 1) * sizeof(double);
+        if (memory_usage + worst_case > memory_budget) return nullptr;
+
+        std::unique_ptr<EccAnomalyTable> table(new EccAnomalyTable(ecc, tolerance, max_intervals));
+        memory_usage += table->get_memory_usage();
+        const EccAnomalyTable *result = table.get();
+        tables.emplace(ecc, std::move(table));
+        return result;
+    }
+
+    void EccAnomalyTableCache::clear() {
+        tables.clear();
+        memory_usage = 0;
+    }
+
+    void EccAnomalyTableCache::set_tolerance(const double value) {
+        tolerance = value;
+        clear();
+    }
+
+    void EccAnomalyTableCache::set_max_intervals(const int value) {
+        max_intervals = value < 64 ? 64 : value;
+        clear();
+    }
+
+    void EccAnomalyTableCache::set_memory_budget(const std::size_t value) {
+        memory_budget = value;
+    }
+
+    double EccAnomalyTableCache::get_tolerance() const {
+        return tolerance;
+    }
+
+    int EccAnomalyTableCache::get_max_intervals() const {
+        return max_intervals;
+    }
+
+    std::size_t EccAnomalyTableCache::get_memory_budget() const {
+        return memory_budget;
+    }
+
+    std::size_t EccAnomalyTableCache::get_memory_usage() const {
+        return memory_usage;
+    }
+
+    int EccAnomalyTableCache::get_table_count() const {
+        return static_cast<int>(tables.size());
+    }
+
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace kepler {
+
+    /**
+    Eccentric anomaly over a full turn of mean anomaly for one fixed eccentricity, as a piecewise cubic Hermite
+    spline. The slope at every knot is the exact dE/dM = 1 / (1 - e cos E), so the spline matches Kepler's
+    equation to fourth order and a lookup is a handful of multiply-adds instead of an iterative solve.
+    */
+    class EccAnomalyTable {
+    public:
+        /**
+        Builds the table, doubling the number of intervals until the interpolation error measured at every
+        interval midpoint is within tolerance or max_intervals is reached.
+
+        @param ecc the eccentricity of the orbits served by this table, must be below 1
+        @param tolerance largest acceptable error in eccentric anomaly (in radians)
+        @param max_intervals upper bound on the table size
+        */
+        EccAnomalyTable(const double ecc, const double tolerance, const int max_intervals);
+
+        /**
+        @param mean_anomaly mean anomaly (in radians), any branch
+        @param refine apply one eps3 correction, which brings the table error down to solver precision
+        @return eccentric anomaly for the mean anomaly reduced to [0, 2 pi)
+        */
+        double get(const double mean_anomaly, const bool refine) const;
+
+        double get_eccentricity() const;
+
+        /**
+        Largest error of an unrefined lookup, measured while building.
+        */
+        double get_max_error() const;
+
+        int get_interval_count() const;
+
+        std::size_t get_memory_usage() const;
+
+    private:
+        void build(const int interval_count);
+
+        double ecc;
+        double max_error;
+        double interval_scale;  // intervals per radian of mean anomaly
+        // Knot value and slope scaled by the interval width, interleaved so a lookup touches one cache line
+        std::vector<double> knots;
+    };
+
+    /**
+    Tables shared by every orbit with the same eccentricity, within a memory budget.
+    */
+    class EccAnomalyTableCache {
+    public:
+        EccAnomalyTableCache();
+
+        /**
+        Returns the table for ecc, building it on first use.
+        Returns nullptr when ecc is out of range or building the table would exceed the memory budget, in which
+        case the caller should fall back to the iterative solver.
+        */
+        const EccAnomalyTable *get(const double ecc);
+
+        void clear();
+
+        void set_tolerance(const double value);
+
+        void set_max_intervals(const int value);
+
+        void set_memory_budget(const std::size_t value);
+
+        double get_tolerance() const;
+
+        int get_max_intervals() const;
+
+        std::size_t get_memory_budget() const;
+
+        std::size_t get_memory_usage() const;
+
+        int get_table_count() const;
+
+    private:
+        std::map<double, std::unique_ptr<EccAnomalyTable>> tables;
+        double tolerance;
+        int max_intervals;
+        std::size_t memory_budget;
+        std::size_t memory_usage;
+    };
+
+}
@@ -0,0 +1,94 @@
+#include <cfloat>
+#include <cmath>
+
+#include "orbit_events.hpp"
+
+namespace orbits {
+
+    void OrbitEventQueue::reset(const int body_count) {
+        entries = std::priority_queue<Entry>();
+        versions.assign(body_count, 0);
+    }
+
+    void OrbitEventQueue::push(const OrbitEvent &event) {
+        // A nan time would never come due, and the periapsis pushed again after it would be nan as well
+        if (!std::isfinite(event.time)) return;
+        Entry entry;
+        entry.event = event;
+        entry.version = versions[event.body];
+        entry.other_version = event.other >= 0 ? versions[event.other] : 0;
+        entries.push(entry);
+    }
+
+    void OrbitEventQueue::invalidate(const int body) {
+        versions[body]++;
+    }
+
+    bool OrbitEventQueue::is_valid(const Entry &entry) const {
+        return entry.version == versions[entry.event.body]
+                && (entry.event.other < 0 || entry.other_version == versions[entry.event.other]);
+    }
+
+    void OrbitEventQueue::drop_stale() {
+        while (!entries.empty() && !is_valid(entries.top())) {
+            entries.pop();
+        }
+    }
+
+    bool OrbitEventQueue::pop(const double time, OrbitEvent &event) {
+        drop_stale();
+        if (entries.empty() || entries.top().event.time > time) return false;
+        event = entries.top().event;
+        entries.pop();
+        return true;
+    }
+
+    double OrbitEventQueue::get_next_time() {
+        drop_stale();
+        return entries.empty() ? INFINITY : entries.top().event.time;
+    }
+
+    int OrbitEventQueue::get_pending_count() const {
+        return static_cast<int>(entries.size());
+    }
+
+    namespace {
+
+        /**
+        How far from time an event can be and still be the one at time: the mean anomaly at time is rounded by
+        both time itself and its reduction to one turn, so searching again from the time of an event can see it
+        a few ulps ahead.
+        */
+        double get_time_resolution(const double time, const OrbitElements &elements) {
+            return 4.0 * DBL_EPSILON * (std::abs(time) + elements.orbital_period);
+        }
+
+    }
+
+    double get_next_periapsis_time(const double time, const OrbitElements &elements) {
+        const double M = get_mean_anomaly(time, elements);
+        double remaining = (2.0 * M_PI - M) / elements.mean_angular_motion;
+        if (remaining <= get_time_resolution(time, elements)) remaining += elements.orbital_period;
+        return time + remaining;
+    }
+
+    double get_next_soi_exit_time(const double time, const OrbitElements &elements, const double soi_radius) {
+        const double e = elements.eccentricity;
+        const double a = elements.semi_major_axis;
+        // Orbits entirely inside or entirely outside never cross
+        if (a * (1.0 + e) <= soi_radius || a * (1.0 - e) >= soi_radius) return INFINITY;
+
+        // Time after periapsis at which the body crosses soi_radius outbound, it crosses back inbound that long
+        // before the next periapsis
+        const double E = std::acos((1.0 - soi_radius / a) / e);
+        const double period = elements.orbital_period;
+        const double crossing = (E - e * std::sin(E)) / elements.mean_angular_motion;
+
+        const double since_periapsis = get_mean_anomaly(time, elements) / elements.mean_angular_motion;
+        double remaining = since_periapsis < crossing ? crossing - since_periapsis
+                                                      : period - since_periapsis + crossing;
+        if (remaining <= get_time_resolution(time, elements)) remaining += period;
+        return time + remaining;
+    }
+
+}
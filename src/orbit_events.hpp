@@ -0,0 +1,106 @@
+#pragma once
+
+#include <queue>
+#include <vector>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    enum OrbitEventType {
+        ORBIT_EVENT_PERIAPSIS = 0,
+        ORBIT_EVENT_SOI_EXIT = 1,
+        ORBIT_EVENT_COLLISION = 2,
+    };
+
+    struct OrbitEvent {
+        double time;
+        int type;
+        int body;
+        int other;  // second body of a collision, -1 otherwise
+    };
+
+    /**
+    The pending events of many bodies, ordered by time.
+
+    Events are never searched for and erased. Invalidating a body bumps its version instead, and events stamped
+    with an older version of either of their bodies are dropped when they reach the front of the queue.
+    */
+    class OrbitEventQueue {
+    public:
+        /**
+        Drops every pending event and sizes the queue for body_count bodies.
+        */
+        void reset(const int body_count);
+
+        /**
+        Adds event, unless its time is not finite, such as the periapsis of an orbit without a period.
+        */
+        void push(const OrbitEvent &event);
+
+        /**
+        Drops every pending event of body, including collisions where it is the other body.
+        */
+        void invalidate(const int body);
+
+        /**
+        Removes the earliest event if it is due no later than time.
+
+        @return false when no valid event is due by time
+        */
+        bool pop(const double time, OrbitEvent &event);
+
+        /**
+        @return time of the earliest pending event, infinity when there is none
+        */
+        double get_next_time();
+
+        int get_pending_count() const;
+
+    private:
+        struct Entry {
+            OrbitEvent event;
+            unsigned version;
+            unsigned other_version;
+
+            bool operator<(const Entry &other) const {
+                // std::priority_queue is a max heap, order it so the earliest event is on top
+                return event.time > other.event.time;
+            }
+        };
+
+        bool is_valid(const Entry &entry) const;
+
+        void drop_stale();
+
+        std::priority_queue<Entry> entries;
+        std::vector<unsigned> versions;
+    };
+
+    /**
+    A passage within the rounding of time counts as the one at time, so searching again from the time of a passage
+    finds the next one.
+
+    @param time current time
+    @param elements the orbit
+    @return earliest time strictly after time at which the body passes periapsis
+    */
+    double get_next_periapsis_time(const double time, const OrbitElements &elements);
+
+    /**
+    The time at which a body leaves the sphere of influence of its primary, solved in closed form from
+    r = a (1 - e cos E) = soi_radius.
+
+    Only crossings count. A body already outside at time is reported when it next leaves after coming back in, so
+    searching again from the time of an exit finds the next exit and not the same one, an exit within the rounding
+    of time counting as the one at time.
+
+    @param time current time
+    @param elements the orbit
+    @param soi_radius radius of the sphere of influence around the focus
+    @return earliest time strictly after time at which the body crosses soi_radius outbound, infinity if the orbit
+            never crosses it
+    */
+    double get_next_soi_exit_time(const double time, const OrbitElements &elements, const double soi_radius);
+
+}
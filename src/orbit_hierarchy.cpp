@@ -0,0 +1,98 @@
+#include "job_pool.hpp"
+#include "orbit_hierarchy.hpp"
+
+namespace orbits {
+
+    // Bodies per task handed to the job pool, one addition each so the tasks need to be large
+    static const int accumulate_grain_size = 4096;
+
+    OrbitHierarchy::OrbitHierarchy() : level_starts(1, 0) {}
+
+    bool OrbitHierarchy::build(const int count, const int *parents) {
+        // Start out flat, which is also what a failed build leaves behind
+        this->parents.assign(count, -1);
+        depths.assign(count, 0);
+        order.resize(count);
+        for (int i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        level_starts.assign(1, 0);
+        level_starts.push_back(count);
+
+        for (int i = 0; i < count; i++) {
+            if (parents[i] < -1 || parents[i] >= count || parents[i] == i) return false;
+        }
+
+        // Depth of every body, walking up until a body of known depth. Depths are filled in along the walk so
+        // every body is walked over once, and a walk longer than the body count went around a cycle.
+        std::vector<int> depth(count, -1);
+        std::vector<int> path;
+        int max_depth = 0;
+        for (int i = 0; i < count; i++) {
+            path.clear();
+            int body = i;
+            while (body >= 0 && depth[body] < 0) {
+                path.push_back(body);
+                if (static_cast<int>(path.size()) > count) return false;
+                body = parents[body];
+            }
+            int d = body < 0 ? -1 : depth[body];
+            for (int k = static_cast<int>(path.size()) - 1; k >= 0; k--) {
+                depth[path[k]] = ++d;
+            }
+            max_depth = d > max_depth ? d : max_depth;
+        }
+
+        // Counting sort by depth, keeping body order within a level
+        level_starts.assign(max_depth + 2, 0);
+        for (int i = 0; i < count; i++) {
+            level_starts[depth[i] + 1]++;
+        }
+        for (int level = 0; level <= max_depth; level++) {
+            level_starts[level + 1] += level_starts[level];
+        }
+        std::vector<int> next(level_starts.begin(), level_starts.end() - 1);
+        for (int i = 0; i < count; i++) {
+            order[next[depth[i]]++] = i;
+        }
+
+        this->parents.assign(parents, parents + count);
+        depths = depth;
+        return true;
+    }
+
+    void OrbitHierarchy::accumulate(godot::Vector2 *positions, godot::Vector2 *velocities, const char *mask) const {
+        const int *body = order.data();
+        const int *parent = parents.data();
+        for (int level = 1; level < get_level_count(); level++) {
+            const int start = level_starts[level];
+            // Levels depend on each other, so only the bodies within one level run in parallel
+            jobs::JobPool::get_singleton().parallel_for(level_starts[level + 1] - start, accumulate_grain_size,
+                                                        [=](int begin, int end) {
+                for (int k = start + begin; k < start + end; k++) {
+                    const int i = body[k];
+                    if (mask && !mask[i]) continue;
+                    positions[i] += positions[parent[i]];
+                    velocities[i] += velocities[parent[i]];
+                }
+            });
+        }
+    }
+
+    bool OrbitHierarchy::is_nested() const {
+        return get_level_count() > 1;
+    }
+
+    int OrbitHierarchy::get_level_count() const {
+        return static_cast<int>(level_starts.size()) - 1;
+    }
+
+    int OrbitHierarchy::get_parent(const int body) const {
+        return parents[body];
+    }
+
+    int OrbitHierarchy::get_depth(const int body) const {
+        return depths[body];
+    }
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include <Godot.hpp>
+
+namespace orbits {
+
+    /**
+    Bodies whose orbits are focused on other bodies, such as moons of planets of a star, flattened into an array
+    sorted by depth so every parent comes before its children.
+
+    Each body's position is first computed relative to the focus of its orbit, with the usual batch propagation.
+    accumulate then turns those into absolute positions by adding the parent's, one level at a time with every
+    level split across the job pool. No scene tree and no transform propagation are involved.
+    */
+    class OrbitHierarchy {
+    public:
+        OrbitHierarchy();
+
+        /**
+        @param count number of bodies
+        @param parents index of the body each body orbits, -1 for bodies orbiting the origin
+        @return false, leaving the hierarchy flat, if parents has an index out of range or a cycle
+        */
+        bool build(const int count, const int *parents);
+
+        /**
+        Adds the position and velocity of each body's parent to its own, parents first, so positions and
+        velocities relative to the focus become relative to the origin.
+
+        @param positions positions relative to each body's focus, absolute on return
+        @param velocities velocities relative to each body's focus, absolute on return
+        @param mask bodies to update, nullptr for all. Must contain the parent of every body it contains.
+        */
+        void accumulate(godot::Vector2 *positions, godot::Vector2 *velocities, const char *mask) const;
+
+        /**
+        @return true when some body orbits another body
+        */
+        bool is_nested() const;
+
+        int get_level_count() const;
+
+        int get_parent(const int body) const;
+
+        int get_depth(const int body) const;
+
+    private:
+        std::vector<int> parents;
+        std::vector<int> depths;
+        std::vector<int> order;         // bodies sorted by depth
+        std::vector<int> level_starts;  // first entry of every level in order, plus the end
+    };
+
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+
+#include "job_pool.hpp"
+#include "orbit_index.hpp"
+
+namespace orbits {
+
+    // Candidate pairs per task handed to the job pool during the narrow phase
+    static const int narrow_phase_grain_size = 64;
+
+    OrbitOverlapIndex::OrbitOverlapIndex() : _dirty(false) {}
+
+    int OrbitOverlapIndex::add(const OrbitElements &elements, const godot::Vector2 focus, const float radius) {
+        this->elements.push_back(elements);
+        foci.push_back(focus);
+        radii.push_back(radius);
+        _dirty = true;
+        return static_cast<int>(this->elements.size()) - 1;
+    }
+
+    void OrbitOverlapIndex::set(const int index, const OrbitElements &elements, const godot::Vector2 focus,
+                                const float radius) {
+        this->elements[index] = elements;
+        foci[index] = focus;
+        radii[index] = radius;
+        _dirty = true;
+    }
+
+    void OrbitOverlapIndex::clear() {
+        elements.clear();
+        foci.clear();
+        radii.clear();
+        _dirty = true;
+    }
+
+    int OrbitOverlapIndex::get_count() const {
+        return static_cast<int>(elements.size());
+    }
+
+    void OrbitOverlapIndex::set_origin(const godot::Vector2 value) {
+        origin = value;
+        _dirty = true;
+    }
+
+    godot::Vector2 OrbitOverlapIndex::get_origin() const {
+        return origin;
+    }
+
+    OrbitOverlapIndex::Annulus OrbitOverlapIndex::get_annulus(const OrbitElements &elements,
+                                                              const godot::Vector2 focus, const float radius,
+                                                              const godot::Vector2 origin) {
+        Annulus annulus;
+        annulus.focus = focus;
+        annulus.inner = std::max(0.0f, elements.semi_major_axis * (1.0f - elements.eccentricity) - radius);
+        annulus.outer = elements.semi_major_axis * (1.0f + elements.eccentricity) + radius;
+
+        // Closest and farthest distance from the origin of any point in the annulus
+        const float d = (focus - origin).length();
+        annulus.start = d > annulus.outer ? d - annulus.outer : (d < annulus.inner ? annulus.inner - d : 0.0f);
+        annulus.end = d + annulus.outer;
+        return annulus;
+    }
+
+    bool OrbitOverlapIndex::overlaps(const Annulus &a, const Annulus &b) {
+        // Overlapping discs, and neither annulus fits entirely inside the hole of the other
+        const float d = (a.focus - b.focus).length();
+        return d <= a.outer + b.outer && d + b.outer >= a.inner && d + a.outer >= b.inner;
+    }
+
+    void OrbitOverlapIndex::build() {
+        if (!_dirty) return;
+        const int count = get_count();
+        _annuli.resize(count);
+        _order.resize(count);
+        for (int i = 0; i < count; i++) {
+            _annuli[i] = get_annulus(elements[i], foci[i], radii[i], origin);
+            _order[i] = i;
+        }
+        std::sort(_order.begin(), _order.end(), [this](int a, int b) {
+            return _annuli[a].start < _annuli[b].start;
+        });
+        _dirty = false;
+    }
+
+    void OrbitOverlapIndex::find_candidate_pairs(std::vector<std::pair<int, int>> &pairs) {
+        build();
+        pairs.clear();
+
+        // Every interval still active when the next one starts overlaps it, so the active list only ever holds
+        // intervals that produce a candidate or are dropped for good
+        std::vector<int> active;
+        for (const int i : _order) {
+            const Annulus &annulus = _annuli[i];
+            int kept = 0;
+            for (const int j : active) {
+                if (_annuli[j].end < annulus.start) continue;
+                active[kept++] = j;
+                if (overlaps(annulus, _annuli[j])) {
+                    pairs.push_back(i < j ? std::make_pair(i, j) : std::make_pair(j, i));
+                }
+            }
+            active.resize(kept);
+            active.push_back(i);
+        }
+    }
+
+    void OrbitOverlapIndex::find_candidates(const OrbitElements &elements, const godot::Vector2 focus,
+                                            const float radius, std::vector<int> &candidates) {
+        build();
+        candidates.clear();
+
+        const Annulus query = get_annulus(elements, focus, radius, origin);
+        for (const int i : _order) {
+            const Annulus &annulus = _annuli[i];
+            if (annulus.start > query.end) break;
+            if (annulus.end >= query.start && overlaps(query, annulus)) {
+                candidates.push_back(i);
+            }
+        }
+    }
+
+    bool OrbitOverlapIndex::can_overlap(const OrbitElements &elements1, const godot::Vector2 focus1,
+                                        const float radius1, const OrbitElements &elements2,
+                                        const godot::Vector2 focus2, const float radius2) {
+        // The sweep range is not needed, any origin will do
+        return overlaps(get_annulus(elements1, focus1, radius1, focus1),
+                        get_annulus(elements2, focus2, radius2, focus1));
+    }
+
+    void OrbitOverlapIndex::find_intercepting_pairs(std::vector<std::pair<int, int>> &pairs) {
+        std::vector<std::pair<int, int>> candidates;
+        find_candidate_pairs(candidates);
+
+        const int count = static_cast<int>(candidates.size());
+        std::vector<char> intercepting(count, 0);
+        const std::pair<int, int> *candidate = candidates.data();
+        char *result = intercepting.data();
+        jobs::JobPool::get_singleton().parallel_for(count, narrow_phase_grain_size, [=](int begin, int end) {
+            godot::Vector2 points[4];
+            for (int k = begin; k < end; k++) {
+                result[k] = find_intercept_points(candidate[k].first, candidate[k].second, points) > 0;
+            }
+        });
+
+        pairs.clear();
+        for (int k = 0; k < count; k++) {
+            if (intercepting[k]) pairs.push_back(candidates[k]);
+        }
+    }
+
+    int OrbitOverlapIndex::find_intercept_points(const int i, const int j, godot::Vector2 *points) const {
+        return orbits::find_intercept_points(elements[i], foci[i], elements[j], foci[j], points);
+    }
+
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <Godot.hpp>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    Broad phase for intercept and collision queries over many orbits.
+
+    Every orbit is bounded by the annulus between its periapsis and apoapsis distance around its focus, widened by
+    a body radius. Two orbits whose annuli do not overlap can never meet, so only the surviving pairs need the
+    exact narrow phase. The annuli are mapped to intervals of distance from a common origin and swept in sorted
+    order, which for orbits around the origin is exact in the radial direction and costs O(N log N + K) for K
+    overlapping pairs instead of testing all N^2 pairs.
+    */
+    class OrbitOverlapIndex {
+    public:
+        OrbitOverlapIndex();
+
+        /**
+        @param elements the orbit
+        @param focus position of the focus of the orbit
+        @param radius radius of the body, 0 for intercept queries
+        @return index of the orbit
+        */
+        int add(const OrbitElements &elements, const godot::Vector2 focus, const float radius);
+
+        void set(const int index, const OrbitElements &elements, const godot::Vector2 focus, const float radius);
+
+        void clear();
+
+        int get_count() const;
+
+        /**
+        Point the sweep measures distances from. Put it at the primary most orbits share.
+        */
+        void set_origin(const godot::Vector2 value);
+
+        godot::Vector2 get_origin() const;
+
+        /**
+        Broad phase, every pair (i, j) with i < j whose annuli overlap.
+        */
+        void find_candidate_pairs(std::vector<std::pair<int, int>> &pairs);
+
+        /**
+        Broad phase for a single orbit that does not need to be in the index.
+        */
+        void find_candidates(const OrbitElements &elements, const godot::Vector2 focus, const float radius,
+                             std::vector<int> &candidates);
+
+        /**
+        Broad phase for a single pair of orbits, neither of which needs to be in the index.
+
+        @return false if the annuli of the two orbits are disjoint, so the bodies can never come within the sum of
+                their radii
+        */
+        static bool can_overlap(const OrbitElements &elements1, const godot::Vector2 focus1, const float radius1,
+                                const OrbitElements &elements2, const godot::Vector2 focus2, const float radius2);
+
+        /**
+        Broad phase followed by find_intercept_points on the survivors, split across the job pool.
+        Every pair (i, j) with i < j whose orbits cross.
+        */
+        void find_intercepting_pairs(std::vector<std::pair<int, int>> &pairs);
+
+        /**
+        Exact crossing points of two indexed orbits, see find_intercept_points.
+        */
+        int find_intercept_points(const int i, const int j, godot::Vector2 *points) const;
+
+    private:
+        struct Annulus {
+            godot::Vector2 focus;
+            float inner;
+            float outer;
+            // Range of distances from the origin covered by the annulus
+            float start;
+            float end;
+        };
+
+        static Annulus get_annulus(const OrbitElements &elements, const godot::Vector2 focus, const float radius,
+                                   const godot::Vector2 origin);
+
+        static bool overlaps(const Annulus &a, const Annulus &b);
+
+        void build();
+
+        std::vector<OrbitElements> elements;
+        std::vector<godot::Vector2> foci;
+        std::vector<float> radii;
+        godot::Vector2 origin;
+
+        // Memoizations
+        std::vector<Annulus> _annuli;
+        std::vector<int> _order;  // indices sorted by annulus start
+        bool _dirty;
+    };
+
+}
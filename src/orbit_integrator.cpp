@@ -0,0 +1,69 @@
+#include <cmath>
+
+#include "job_pool.hpp"
+#include "orbit_integrator.hpp"
+
+namespace orbits {
+
+    // Bodies per task handed to the job pool, each one a few to a few thousand substeps
+    static const int integration_grain_size = 64;
+
+    // Upper bound on the substeps of one call, for bodies that pass right through the primary
+    static const int max_substeps = 4096;
+
+    void integrate_leapfrog(
+            StateVector2D &state,
+            const double standard_gravitational_parameter,
+            const godot::Vector2 acceleration,
+            const double duration,
+            const double step_fraction
+    ) {
+        const double mu = standard_gravitational_parameter;
+        double x = state.x, y = state.y, vx = state.vx, vy = state.vy;
+
+        const double r2 = x * x + y * y;
+        const double free_fall_time = std::sqrt(r2 * std::sqrt(r2) / mu);
+        const double substeps = std::ceil(std::fabs(duration) / (step_fraction * free_fall_time));
+        const int n = substeps < 1.0 ? 1 : (substeps > max_substeps ? max_substeps : static_cast<int>(substeps));
+        const double h = duration / n;
+
+        // Consecutive half kicks of neighbouring substeps are merged into one full kick
+        double ax, ay;
+        const auto accelerate = [&]() {
+            const double d2 = x * x + y * y;
+            const double k = -mu / (d2 * std::sqrt(d2));
+            ax = k * x + acceleration.x;
+            ay = k * y + acceleration.y;
+        };
+        accelerate();
+        vx += 0.5 * h * ax;
+        vy += 0.5 * h * ay;
+        for (int step = 0; step < n; step++) {
+            x += h * vx;
+            y += h * vy;
+            accelerate();
+            const double kick = step == n - 1 ? 0.5 * h : h;
+            vx += kick * ax;
+            vy += kick * ay;
+        }
+
+        state = StateVector2D{x, y, vx, vy};
+    }
+
+    void integrate_leapfrog_batch(
+            const int count,
+            StateVector2D *states,
+            const double *standard_gravitational_parameters,
+            const godot::Vector2 *accelerations,
+            const double duration,
+            const double step_fraction
+    ) {
+        jobs::JobPool::get_singleton().parallel_for(count, integration_grain_size, [=](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                integrate_leapfrog(states[i], standard_gravitational_parameters[i], accelerations[i], duration,
+                                   step_fraction);
+            }
+        });
+    }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Godot.hpp>
+
+namespace orbits {
+
+    /**
+    Position and velocity relative to the primary, in double so a state integrated over many steps does not pick
+    up float rounding on every one of them.
+    */
+    struct StateVector2D {
+        double x;
+        double y;
+        double vx;
+        double vy;
+    };
+
+    /**
+    Advances a body under the gravity of a primary at the origin plus a constant acceleration, such as the thrust
+    of a ship, with kick-drift-kick leapfrog.
+
+    Leapfrog is symplectic and time reversible: the energy of a coasting body oscillates around its true value
+    instead of drifting away the way it does with the explicit Euler steps of a generic physics engine, and a
+    negative duration steps back along the same path. duration is split into equal substeps no longer than
+    step_fraction of the free fall time sqrt(r^3 / mu) at the start, so close passes take more of them.
+
+    @param state the body, advanced by duration on return
+    @param standard_gravitational_parameter of the primary
+    @param acceleration acceleration on top of gravity, held constant over duration
+    @param duration time to advance by, may be negative
+    @param step_fraction longest substep as a fraction of the free fall time
+    */
+    void integrate_leapfrog(
+            StateVector2D &state,
+            const double standard_gravitational_parameter,
+            const godot::Vector2 acceleration,
+            const double duration,
+            const double step_fraction
+    );
+
+    /**
+    integrate_leapfrog for count bodies, split across the job pool.
+    */
+    void integrate_leapfrog_batch(
+            const int count,
+            StateVector2D *states,
+            const double *standard_gravitational_parameters,
+            const godot::Vector2 *accelerations,
+            const double duration,
+            const double step_fraction
+    );
+
+}
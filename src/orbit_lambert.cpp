@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "job_pool.hpp"
+#include "orbit_lambert.hpp"
+#include "orbit_universal.hpp"
+
+namespace orbits {
+
+    // Porkchop rows per task handed to the job pool, a row is a whole sweep over the arrival times
+    static const int porkchop_grain_size = 1;
+
+    namespace {
+        /**
+        Time of flight as a function of the universal variable z, scaled by sqrt(mu) and offset by the wanted
+        one, see Curtis, Orbital Mechanics for Engineering Students, algorithm 5.2.
+        */
+        struct TimeOfFlight {
+            const double r1;
+            const double r2;
+            const double A;
+            const double target;
+
+            /**
+            @return value at z, with y(z) and the derivative. Where y is negative the transfer would take no time at
+                    all, which is reported as -target with a derivative of nan.
+            */
+            double operator()(const double z, double &y, double &derivative) const {
+                double c0, c1, c, s;
+                get_stumpff(z, c0, c1, c, s);
+                y = r1 + r2 + A * (z * s - 1.0) / std::sqrt(c);
+                if (y < 0.0) {
+                    derivative = NAN;
+                    return -target;
+                }
+                const double sqrt_y = std::sqrt(y);
+                const double chi3 = std::pow(y / c, 1.5);
+                if (std::fabs(z) > 1e-3) {
+                    derivative = chi3 * ((c - 1.5 * s / c) / (2.0 * z) + 0.75 * s * s / c)
+                            + A / 8.0 * (3.0 * s / c * sqrt_y + A * std::sqrt(c / y));
+                } else {
+                    derivative = std::sqrt(2.0) / 40.0 * y * sqrt_y + A / 8.0 * (sqrt_y + A * std::sqrt(0.5 / y));
+                }
+                return chi3 * s + A * sqrt_y - target;
+            }
+        };
+
+        /**
+        Body states along both axes of a porkchop grid, each computed once.
+        */
+        struct Porkchop {
+            std::vector<PositionVelocity2D> departures;
+            std::vector<PositionVelocity2D> arrivals;
+            std::vector<double> departure_times;
+            std::vector<double> arrival_times;
+            double standard_gravitational_parameter;
+
+            Porkchop(const OrbitElements &departure_orbit, const OrbitElements &arrival_orbit,
+                     const double departure_start, const double departure_step, const int departure_count,
+                     const double arrival_start, const double arrival_step, const int arrival_count)
+                    : standard_gravitational_parameter(departure_orbit.standard_gravitational_parameter) {
+                for (int i = 0; i < departure_count; i++) {
+                    departure_times.push_back(departure_start + i * departure_step);
+                    departures.push_back(get_heliocentric_position_velocity_from_time(departure_times[i],
+                                                                                       departure_orbit));
+                }
+                for (int j = 0; j < arrival_count; j++) {
+                    arrival_times.push_back(arrival_start + j * arrival_step);
+                    arrivals.push_back(get_heliocentric_position_velocity_from_time(arrival_times[j], arrival_orbit));
+                }
+            }
+
+            float get_delta_v(const int i, const int j) const {
+                const double time_of_flight = arrival_times[j] - departure_times[i];
+                godot::Vector2 v1, v2;
+                if (!(time_of_flight > 0.0)) return INFINITY;
+                if (!solve_lambert(departures[i].p, arrivals[j].p, time_of_flight, standard_gravitational_parameter,
+                                   v1, v2)) {
+                    return INFINITY;
+                }
+                return (v1 - departures[i].v).length() + (arrivals[j].v - v2).length();
+            }
+        };
+
+        /**
+        Every stride-th index below count, plus the last one so every index lies between two samples.
+        */
+        std::vector<int> get_samples(const int count, const int stride) {
+            std::vector<int> samples;
+            for (int i = 0; i < count; i += stride) {
+                samples.push_back(i);
+            }
+            if (samples.back() != count - 1) samples.push_back(count - 1);
+            return samples;
+        }
+    }
+
+    bool solve_lambert(
+            const godot::Vector2 from,
+            const godot::Vector2 to,
+            const double time_of_flight,
+            const double standard_gravitational_parameter,
+            godot::Vector2 &departure_velocity,
+            godot::Vector2 &arrival_velocity
+    ) {
+        const double x1 = from.x, y1 = from.y, x2 = to.x, y2 = to.y;
+        const double r1 = std::sqrt(x1 * x1 + y1 * y1);
+        const double r2 = std::sqrt(x2 * x2 + y2 * y2);
+        const double mu = standard_gravitational_parameter;
+        if (!(time_of_flight > 0.0) || !(r1 > 0.0) || !(r2 > 0.0) || !(mu > 0.0)) return false;
+
+        // Counter-clockwise transfer angle, A vanishes at 0 and 180 degrees where the transfer is not unique
+        double angle = std::atan2(x1 * y2 - y1 * x2, x1 * x2 + y1 * y2);
+        if (angle < 0.0) angle += 2.0 * M_PI;
+        const double A = std::sin(angle) * std::sqrt(r1 * r2 / (1.0 - std::cos(angle)));
+        if (!(std::fabs(A) > 1e-9 * (r1 + r2))) return false;
+
+        // Time of flight rises with z, from nothing up to infinity at 4 pi^2 where the transfer takes a whole
+        // revolution. Widen the lower end until it brackets the wanted time, short hyperbolic transfers lie far out.
+        const TimeOfFlight f{r1, r2, A, std::sqrt(mu) * time_of_flight};
+        double y, derivative;
+        double low = -4.0 * M_PI * M_PI;
+        double high = 4.0 * M_PI * M_PI;
+        while (f(low, y, derivative) > 0.0) {
+            if (low < -1e5) return false;
+            low *= 2.0;
+        }
+
+        double z = 0.0;
+        for (int iteration = 0; iteration < 100; iteration++) {
+            const double value = f(z, y, derivative);
+            if (value < 0.0) {
+                low = z;
+            } else {
+                high = z;
+            }
+            if (std::fabs(value) <= 1e-12 * f.target || high - low <= 1e-14 * (1.0 + std::fabs(z))) break;
+            // Newton where it stays inside the bracket, bisection otherwise
+            const double step = z - value / derivative;
+            z = step > low && step < high ? step : 0.5 * (low + high);
+        }
+        if (!(y > 0.0)) return false;
+
+        // Lagrange coefficients
+        const double f_coefficient = 1.0 - y / r1;
+        const double g = A * std::sqrt(y / mu);
+        const double g_dot = 1.0 - y / r2;
+        departure_velocity = godot::Vector2((x2 - f_coefficient * x1) / g, (y2 - f_coefficient * y1) / g);
+        arrival_velocity = godot::Vector2((g_dot * x2 - x1) / g, (g_dot * y2 - y1) / g);
+        return true;
+    }
+
+    void get_porkchop_grid(
+            const OrbitElements &departure_orbit,
+            const OrbitElements &arrival_orbit,
+            const double departure_start,
+            const double departure_step,
+            const int departure_count,
+            const double arrival_start,
+            const double arrival_step,
+            const int arrival_count,
+            float *delta_v
+    ) {
+        get_porkchop_grid_refined(departure_orbit, arrival_orbit, departure_start, departure_step, departure_count,
+                                  arrival_start, arrival_step, arrival_count, 1, delta_v);
+    }
+
+    void get_porkchop_grid_refined(
+            const OrbitElements &departure_orbit,
+            const OrbitElements &arrival_orbit,
+            const double departure_start,
+            const double departure_step,
+            const int departure_count,
+            const double arrival_start,
+            const double arrival_step,
+            const int arrival_count,
+            const int coarse_stride,
+            float *delta_v
+    ) {
+        if (departure_count <= 0 || arrival_count <= 0) return;
+        const Porkchop porkchop(departure_orbit, arrival_orbit, departure_start, departure_step, departure_count,
+                                arrival_start, arrival_step, arrival_count);
+        const Porkchop *problem = &porkchop;
+        if (coarse_stride <= 1) {
+            jobs::JobPool::get_singleton().parallel_for(departure_count, porkchop_grain_size, [=](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    for (int j = 0; j < arrival_count; j++) {
+                        delta_v[i * arrival_count + j] = problem->get_delta_v(i, j);
+                    }
+                }
+            });
+            return;
+        }
+        const int stride = coarse_stride;
+
+        // Coarse pass
+        const std::vector<int> rows = get_samples(departure_count, stride);
+        const std::vector<int> columns = get_samples(arrival_count, stride);
+        const int row_count = static_cast<int>(rows.size());
+        const int column_count = static_cast<int>(columns.size());
+        std::vector<float> coarse(row_count * column_count);
+        const int *row_indices = rows.data();
+        const int *column_indices = columns.data();
+        float *coarse_values = coarse.data();
+        jobs::JobPool::get_singleton().parallel_for(row_count, porkchop_grain_size, [=](int begin, int end) {
+            for (int a = begin; a < end; a++) {
+                for (int b = 0; b < column_count; b++) {
+                    coarse_values[a * column_count + b] = problem->get_delta_v(row_indices[a], column_indices[b]);
+                }
+            }
+        });
+
+        // Cells out to the neighbouring coarse samples of every coarse local minimum are solved exactly
+        std::vector<char> exact(departure_count * arrival_count, 0);
+        for (int a = 0; a < row_count; a++) {
+            for (int b = 0; b < column_count; b++) {
+                const float value = coarse[a * column_count + b];
+                if (value == INFINITY) continue;
+                const int a0 = a > 0 ? a - 1 : 0, a1 = a < row_count - 1 ? a + 1 : a;
+                const int b0 = b > 0 ? b - 1 : 0, b1 = b < column_count - 1 ? b + 1 : b;
+                bool minimum = true;
+                for (int na = a0; na <= a1; na++) {
+                    for (int nb = b0; nb <= b1; nb++) {
+                        minimum = minimum && coarse[na * column_count + nb] >= value;
+                    }
+                }
+                if (!minimum) continue;
+                for (int i = rows[a0]; i <= rows[a1]; i++) {
+                    for (int j = columns[b0]; j <= columns[b1]; j++) {
+                        exact[i * arrival_count + j] = 1;
+                    }
+                }
+            }
+        }
+
+        // Fine pass, every other cell is interpolated between the four coarse samples around it, or takes the
+        // nearest one where a neighbour has no transfer
+        const char *exact_cells = exact.data();
+        jobs::JobPool::get_singleton().parallel_for(departure_count, porkchop_grain_size, [=](int begin, int end) {
+            for (int i = begin; i < end; i++) {
+                const int a = row_count > 1 ? std::min(i / stride, row_count - 2) : 0;
+                const int a1 = a + 1 < row_count ? a + 1 : a;
+                const float u = a1 > a ? float(i - row_indices[a]) / (row_indices[a1] - row_indices[a]) : 0.0f;
+                for (int j = 0; j < arrival_count; j++) {
+                    float &cell = delta_v[i * arrival_count + j];
+                    if (exact_cells[i * arrival_count + j]) {
+                        cell = problem->get_delta_v(i, j);
+                        continue;
+                    }
+                    const int b = column_count > 1 ? std::min(j / stride, column_count - 2) : 0;
+                    const int b1 = b + 1 < column_count ? b + 1 : b;
+                    const float v = b1 > b ? float(j - column_indices[b]) / (column_indices[b1] - column_indices[b])
+                            : 0.0f;
+                    const float c00 = coarse_values[a * column_count + b];
+                    const float c01 = coarse_values[a * column_count + b1];
+                    const float c10 = coarse_values[a1 * column_count + b];
+                    const float c11 = coarse_values[a1 * column_count + b1];
+                    if (c00 != INFINITY && c01 != INFINITY && c10 != INFINITY && c11 != INFINITY) {
+                        cell = (1.0f - u) * ((1.0f - v) * c00 + v * c01) + u * ((1.0f - v) * c10 + v * c11);
+                    } else {
+                        cell = coarse_values[(u < 0.5f ? a : a1) * column_count + (v < 0.5f ? b : b1)];
+                    }
+                }
+            }
+        });
+    }
+
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <Godot.hpp>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    Solves Lambert's problem: the orbit around a primary at the origin that leads from one position to another in a
+    given time, as the velocities at both ends. Uses the universal variable formulation, so the transfer may be
+    elliptic, parabolic or hyperbolic, solved for z by Newton's method kept inside a bracket by bisection.
+
+    Transfers run counter-clockwise like every orbit here, and take less than one revolution.
+
+    @param from departure position
+    @param to arrival position
+    @param time_of_flight time between departure and arrival
+    @param standard_gravitational_parameter of the primary
+    @param departure_velocity output, velocity right after departure
+    @param arrival_velocity output, velocity right before arrival
+    @return false when there is no solution, for a time of flight that is not positive or a transfer angle of
+            exactly 0 or 180 degrees
+    */
+    bool solve_lambert(
+            const godot::Vector2 from,
+            const godot::Vector2 to,
+            const double time_of_flight,
+            const double standard_gravitational_parameter,
+            godot::Vector2 &departure_velocity,
+            godot::Vector2 &arrival_velocity
+    );
+
+    /**
+    Delta-v of the transfers between two orbits around the same focus, for every pair of a departure time and an
+    arrival time, as used for porkchop plots. A cell is the speed change to leave the departure orbit plus the
+    one to match the arrival orbit, infinity where arrival is not after departure or there is no solution.
+
+    Departure and arrival positions are computed once per row and column, and the rows are split across the job
+    pool.
+
+    @param delta_v output, departure_count rows of arrival_count cells
+    */
+    void get_porkchop_grid(
+            const OrbitElements &departure_orbit,
+            const OrbitElements &arrival_orbit,
+            const double departure_start,
+            const double departure_step,
+            const int departure_count,
+            const double arrival_start,
+            const double arrival_step,
+            const int arrival_count,
+            float *delta_v
+    );
+
+    /**
+    get_porkchop_grid solving only every coarse_stride-th row and column first. Around every local minimum of that
+    coarse grid the cells are then solved exactly, out to the neighbouring coarse samples, while every other cell
+    is interpolated from the coarse grid. The minima come out exact at a fraction of the cost of the full grid.
+
+    @param coarse_stride spacing of the coarse samples in cells, 1 solves the full grid
+    */
+    void get_porkchop_grid_refined(
+            const OrbitElements &departure_orbit,
+            const OrbitElements &arrival_orbit,
+            const double departure_start,
+            const double departure_step,
+            const int departure_count,
+            const double arrival_start,
+            const double arrival_step,
+            const int arrival_count,
+            const int coarse_stride,
+            float *delta_v
+    );
+
+}
@@ -0,0 +1,156 @@
+#include <algorithm>
+#include <cmath>
+
+#include "job_pool.hpp"
+#include "orbit_nbody.hpp"
+
+namespace orbits {
+
+    // Query points per task handed to the job pool
+    static const int query_grain_size = 64;
+
+    // Bodies below which a node is not split any further and summed directly
+    static const int leaf_size = 8;
+
+    // Depth at which splitting stops, for bodies sitting on top of each other
+    static const int max_depth = 24;
+
+    void BarnesHutTree::build(const int count, const godot::Vector2 *positions, const float *gravitational_parameters) {
+        this->positions.assign(positions, positions + count);
+        this->gravitational_parameters.assign(gravitational_parameters, gravitational_parameters + count);
+        nodes.clear();
+        order.clear();
+
+        godot::Vector2 low, high;
+        for (int i = 0; i < count; i++) {
+            if (!(gravitational_parameters[i] > 0.0f)) continue;
+            if (order.empty()) {
+                low = high = positions[i];
+            } else {
+                low = godot::Vector2(std::fmin(low.x, positions[i].x), std::fmin(low.y, positions[i].y));
+                high = godot::Vector2(std::fmax(high.x, positions[i].x), std::fmax(high.y, positions[i].y));
+            }
+            order.push_back(i);
+        }
+        if (order.empty()) return;
+
+        const godot::Vector2 extent = high - low;
+        const float half_size = 0.5f * std::fmax(extent.x, extent.y);
+        build_node(0, static_cast<int>(order.size()), (low + high) * 0.5f, half_size > 0.0f ? half_size : 1.0f, 0);
+    }
+
+    int BarnesHutTree::build_node(const int begin, const int end, const godot::Vector2 center, const float half_size,
+                                  const int depth) {
+        const int index = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+        Node node;
+        node.center = center;
+        node.half_size = half_size;
+        node.begin = begin;
+        node.end = end;
+        node.children[0] = node.children[1] = node.children[2] = node.children[3] = -1;
+
+        // Mass and center of mass in double, a node can hold many bodies of very different mass
+        double mu = 0.0, x = 0.0, y = 0.0;
+        for (int k = begin; k < end; k++) {
+            const double body_mu = gravitational_parameters[order[k]];
+            mu += body_mu;
+            x += body_mu * positions[order[k]].x;
+            y += body_mu * positions[order[k]].y;
+        }
+        node.gravitational_parameter = static_cast<float>(mu);
+        node.center_of_mass = godot::Vector2(x / mu, y / mu);
+
+        if (end - begin > leaf_size && depth < max_depth) {
+            // Sort the bodies into quadrants, bottom and top first, then left and right within each
+            int *first = order.data() + begin;
+            int *last = order.data() + end;
+            const godot::Vector2 *p = positions.data();
+            int *middle = std::partition(first, last, [=](int i) { return p[i].y < center.y; });
+            int *bounds[5] = {
+                    first,
+                    std::partition(first, middle, [=](int i) { return p[i].x < center.x; }),
+                    middle,
+                    std::partition(middle, last, [=](int i) { return p[i].x < center.x; }),
+                    last
+            };
+            const float quarter = 0.5f * half_size;
+            for (int quadrant = 0; quadrant < 4; quadrant++) {
+                if (bounds[quadrant] == bounds[quadrant + 1]) continue;
+                const godot::Vector2 child_center(center.x + (quadrant & 1 ? quarter : -quarter),
+                                                  center.y + (quadrant & 2 ? quarter : -quarter));
+                node.children[quadrant] = build_node(static_cast<int>(bounds[quadrant] - order.data()),
+                                                     static_cast<int>(bounds[quadrant + 1] - order.data()),
+                                                     child_center, quarter, depth + 1);
+            }
+        }
+
+        nodes[index] = node;
+        return index;
+    }
+
+    godot::Vector2 BarnesHutTree::get_acceleration(const godot::Vector2 point, const int ignore,
+                                                   const float opening_angle, const float softening) const {
+        if (nodes.empty()) return godot::Vector2();
+        const double theta2 = static_cast<double>(opening_angle) * opening_angle;
+        const double eps2 = static_cast<double>(softening) * softening;
+        double ax = 0.0, ay = 0.0;
+        const auto attract = [&](const godot::Vector2 source, const double mu) {
+            const double dx = source.x - point.x;
+            const double dy = source.y - point.y;
+            const double d2 = dx * dx + dy * dy + eps2;
+            if (d2 == 0.0) return;
+            const double k = mu / (d2 * std::sqrt(d2));
+            ax += k * dx;
+            ay += k * dy;
+        };
+
+        // Every level holds at most 3 pending siblings besides the node being opened
+        int stack[4 * max_depth + 4];
+        int top = 0;
+        stack[top++] = 0;
+        while (top > 0) {
+            const Node &node = nodes[stack[--top]];
+
+            // A node containing the point is always opened, which also keeps the ignored body out of every aggregate
+            // around it
+            const bool inside = std::fabs(point.x - node.center.x) <= node.half_size
+                    && std::fabs(point.y - node.center.y) <= node.half_size;
+            if (!inside) {
+                const double dx = node.center_of_mass.x - point.x;
+                const double dy = node.center_of_mass.y - point.y;
+                const double size = 2.0 * node.half_size;
+                if (size * size < theta2 * (dx * dx + dy * dy)) {
+                    attract(node.center_of_mass, node.gravitational_parameter);
+                    continue;
+                }
+            }
+
+            if (node.children[0] < 0 && node.children[1] < 0 && node.children[2] < 0 && node.children[3] < 0) {
+                for (int k = node.begin; k < node.end; k++) {
+                    if (order[k] != ignore) attract(positions[order[k]], gravitational_parameters[order[k]]);
+                }
+                continue;
+            }
+            for (const int child : node.children) {
+                if (child >= 0) stack[top++] = child;
+            }
+        }
+        return godot::Vector2(ax, ay);
+    }
+
+    void BarnesHutTree::get_acceleration_batch(const int count, const godot::Vector2 *points, const int *ignore,
+                                               const float opening_angle, const float softening,
+                                               godot::Vector2 *accelerations) const {
+        jobs::JobPool::get_singleton().parallel_for(count, query_grain_size, [=](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                accelerations[k] = get_acceleration(points[k], ignore ? ignore[k] : -1, opening_angle, softening);
+            }
+        });
+    }
+
+    int BarnesHutTree::get_node_count() const {
+        return static_cast<int>(nodes.size());
+    }
+
+}
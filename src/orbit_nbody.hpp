@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+
+#include <Godot.hpp>
+
+namespace orbits {
+
+    /**
+    Barnes-Hut quadtree over the massive bodies of a system, for the mutual gravity of clusters and debris fields
+    that the single focus Kepler model leaves out.
+
+    Every node of the tree carries the total standard gravitational parameter and the center of mass of the bodies
+    below it. A query walks the tree from the root and takes a node as a single point mass once it looks smaller
+    than opening_angle radians from the query point, so each query costs O(log N) instead of summing over all N
+    bodies. An opening angle of 0 opens every node and gives the exact direct sum.
+    */
+    class BarnesHutTree {
+    public:
+        /**
+        Rebuilds the tree, meant to be called once per step before the queries of that step.
+
+        @param count number of bodies
+        @param positions position of every body
+        @param gravitational_parameters standard gravitational parameter of every body, bodies with 0 are left out
+        */
+        void build(const int count, const godot::Vector2 *positions, const float *gravitational_parameters);
+
+        /**
+        @param point where the acceleration is felt
+        @param ignore body left out of the sum, usually the one at point, -1 for none
+        @param opening_angle largest size over distance of a node taken as a single point mass
+        @param softening length added in quadrature to every distance, keeps close passes finite
+        @return the gravitational acceleration at point
+        */
+        godot::Vector2 get_acceleration(const godot::Vector2 point, const int ignore, const float opening_angle,
+                                        const float softening) const;
+
+        /**
+        get_acceleration for count points, split across the job pool.
+        */
+        void get_acceleration_batch(const int count, const godot::Vector2 *points, const int *ignore,
+                                    const float opening_angle, const float softening,
+                                    godot::Vector2 *accelerations) const;
+
+        int get_node_count() const;
+
+    private:
+        struct Node {
+            godot::Vector2 center;  // of the square the node covers
+            float half_size;
+            godot::Vector2 center_of_mass;
+            float gravitational_parameter;
+            int children[4];        // -1 for empty quadrants, all -1 for leaves
+            int begin;              // bodies of the node in order
+            int end;
+        };
+
+        int build_node(const int begin, const int end, const godot::Vector2 center, const float half_size,
+                       const int depth);
+
+        std::vector<Node> nodes;
+        std::vector<int> order;  // massive bodies, grouped by node
+        std::vector<godot::Vector2> positions;
+        std::vector<float> gravitational_parameters;
+    };
+
+}
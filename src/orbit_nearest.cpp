@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "job_pool.hpp"
+#include "orbit_nearest.hpp"
+
+namespace orbits {
+
+    // Points per task handed to the job pool, each one a few dozen divisions and square roots
+    static const int query_grain_size = 256;
+
+    // Two evolute iterations land within about 1e-2 of the foot point even at e = 0.9999, and Newton takes it from
+    // there, in a handful of steps at most
+    static const int evolute_iterations = 2;
+    static const int max_newton_iterations = 10;
+    static const double newton_tolerance = 1e-12;
+
+    namespace {
+
+        /**
+        Point of an axis aligned ellipse around the origin closest to (x, y), both coordinates non-negative, as the
+        cosine and sine of its eccentric anomaly in [0, pi / 2].
+        */
+        void get_nearest_eccentric_anomaly(const double a, const double b, const double x, const double y,
+                                           double &cos_E, double &sin_E) {
+            // Follow the centre of curvature: the foot point sits where the line from the evolute point through
+            // the query point meets the ellipse at the radius of curvature. See "Distance from a point to an
+            // ellipse", 0xfaded, 2017.
+            const double c2 = a * a - b * b;
+            double tx = M_SQRT1_2;
+            double ty = M_SQRT1_2;
+            for (int i = 0; i < evolute_iterations; i++) {
+                const double ex = c2 * tx * tx * tx / a;
+                const double ey = -c2 * ty * ty * ty / b;
+                const double rx = a * tx - ex;
+                const double ry = b * ty - ey;
+                const double qx = x - ex;
+                const double qy = y - ey;
+                const double r = std::sqrt(rx * rx + ry * ry);
+                const double q = std::sqrt(qx * qx + qy * qy);
+                if (!(q > 0.0)) break;  // on the evolute itself, every direction is as good
+                tx = std::min(1.0, std::max(0.0, (qx * r / q + ex) / a));
+                ty = std::min(1.0, std::max(0.0, (qy * r / q + ey) / b));
+                const double t = std::sqrt(tx * tx + ty * ty);
+                tx /= t;
+                ty /= t;
+            }
+
+            // The evolute iterations slow down on eccentric orbits, Newton on the derivative of the squared distance
+            // finishes the job. The steps are small, so they rotate (cos E, sin E) by a series instead of calling
+            // sin and cos, and a step is only kept when it gets closer.
+            double best = (a * tx - x) * (a * tx - x) + (b * ty - y) * (b * ty - y);
+            for (int i = 0; i < max_newton_iterations; i++) {
+                const double g = c2 * ty * tx - a * x * ty + b * y * tx;
+                const double dg = c2 * (tx * tx - ty * ty) - a * x * tx - b * y * ty;
+                if (dg == 0.0) break;
+                const double step = -g / dg;
+                const double step2 = step * step;
+                const double sin_step = step * (1.0 - step2 / 6.0 * (1.0 - step2 / 20.0));
+                const double cos_step = 1.0 - step2 / 2.0 * (1.0 - step2 / 12.0);
+                double nx = std::max(0.0, tx * cos_step - ty * sin_step);
+                double ny = std::max(0.0, ty * cos_step + tx * sin_step);
+                const double t = std::sqrt(nx * nx + ny * ny);
+                nx /= t;
+                ny /= t;
+                const double distance2 = (a * nx - x) * (a * nx - x) + (b * ny - y) * (b * ny - y);
+                if (!(distance2 <= best)) break;
+                tx = nx;
+                ty = ny;
+                best = distance2;
+                if (std::abs(step) < newton_tolerance) break;
+            }
+            cos_E = tx;
+            sin_E = ty;
+        }
+
+    }
+
+    NearestPoint get_nearest_point(const OrbitElements &elements, const godot::Vector2 focus,
+                                   const godot::Vector2 position, const double time) {
+        const double e = elements.eccentricity;
+        const double a = elements.semi_major_axis;
+        const double b = elements.semi_minor_axis;
+        const double cos_w = elements.cos_argument_of_periapsis;
+        const double sin_w = elements.sin_argument_of_periapsis;
+
+        // Query point in the frame of the ellipse, centred on it with periapsis along +x
+        const double dx = static_cast<double>(position.x) - focus.x + elements.linear_eccentricity * cos_w;
+        const double dy = static_cast<double>(position.y) - focus.y + elements.linear_eccentricity * sin_w;
+        const double x = dx * cos_w + dy * sin_w;
+        const double y = dy * cos_w - dx * sin_w;
+
+        // The ellipse is symmetric about both axes, so solve in the first quadrant and mirror back
+        double cos_E, sin_E;
+        get_nearest_eccentric_anomaly(a, b, std::abs(x), std::abs(y), cos_E, sin_E);
+        cos_E = std::copysign(cos_E, x);
+        sin_E = std::copysign(sin_E, y);
+        const double E = std::atan2(sin_E, cos_E);
+
+        const double px = a * cos_E;
+        const double py = b * sin_E;
+        NearestPoint nearest;
+        nearest.point = godot::Vector2(
+                focus.x - elements.linear_eccentricity * cos_w + px * cos_w - py * sin_w,
+                focus.y - elements.linear_eccentricity * sin_w + px * sin_w + py * cos_w);
+        nearest.distance = static_cast<float>(std::sqrt((px - x) * (px - x) + (py - y) * (py - y)));
+        nearest.eccentric_anomaly = static_cast<float>(E);
+        nearest.true_anomaly = static_cast<float>(std::atan2(std::sqrt(1.0 - e * e) * sin_E, cos_E - e));
+
+        double mean_anomaly = E - e * sin_E - get_mean_anomaly(time, elements);
+        mean_anomaly -= 2.0 * M_PI * std::floor(mean_anomaly / (2.0 * M_PI));
+        nearest.time_of_flight = mean_anomaly / elements.mean_angular_motion;
+        return nearest;
+    }
+
+    void get_nearest_points_batch(const OrbitElements &elements, const godot::Vector2 focus, const int count,
+                                  const godot::Vector2 *positions, const double time, NearestPoint *nearest) {
+        const OrbitElements orbit = elements;
+        jobs::JobPool::get_singleton().parallel_for(count, query_grain_size, [=](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                nearest[k] = get_nearest_point(orbit, focus, positions[k], time);
+            }
+        });
+    }
+
+    float get_nearest_distance_lower_bound(const OrbitElements &elements, const godot::Vector2 focus,
+                                           const godot::Vector2 position) {
+        const float distance = (position - focus).length();
+        const float periapsis = elements.semi_major_axis - elements.linear_eccentricity;
+        const float apoapsis = elements.semi_major_axis + elements.linear_eccentricity;
+        return std::max(0.0f, std::max(periapsis - distance, distance - apoapsis));
+    }
+
+    int find_nearest_orbit(const int count, const OrbitElements *elements, const godot::Vector2 *foci,
+                           const char *mask, const godot::Vector2 position, const float max_distance,
+                           const double time, NearestPoint &nearest) {
+        std::vector<std::pair<float, int>> candidates;
+        for (int i = 0; i < count; i++) {
+            if (mask && !mask[i]) continue;
+            const float bound = get_nearest_distance_lower_bound(elements[i], foci[i], position);
+            if (bound <= max_distance) candidates.push_back({bound, i});
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        int found = -1;
+        float best = max_distance;
+        for (const auto &candidate : candidates) {
+            if (candidate.first > best) break;
+            const NearestPoint point = get_nearest_point(elements[candidate.second], foci[candidate.second], position,
+                                                         time);
+            if (point.distance <= best) {
+                best = point.distance;
+                found = candidate.second;
+                nearest = point;
+            }
+        }
+        return found;
+    }
+
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <Godot.hpp>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    The point of an orbit closest to a query point, with where on the orbit it is.
+    */
+    struct NearestPoint {
+        godot::Vector2 point;
+        float distance;           // from the query point to point
+        float eccentric_anomaly;  // of point, in [-pi, pi]
+        float true_anomaly;       // of point, in [-pi, pi]
+        double time_of_flight;    // for the body to get from where it is at the query time to point, in [0, period)
+    };
+
+    /**
+    Closest point of an elliptic orbit to position, for picking orbits under the cursor and snapping manoeuvre nodes
+    onto them.
+
+    Works in double in the frame of the ellipse, folded into its first quadrant. Two trig free iterations of the
+    evolute construction land close to the foot point from anywhere, inside the ellipse as well as outside, and
+    Newton steps on the eccentric anomaly polish it to full precision. The steps rotate its cosine and sine
+    directly, so the whole query costs no sin or cos calls and two atan2.
+
+    @param focus position of the focus of the orbit
+    @param position query point
+    @param time time the time of flight is measured from
+    */
+    NearestPoint get_nearest_point(
+            const OrbitElements &elements,
+            const godot::Vector2 focus,
+            const godot::Vector2 position,
+            const double time
+    );
+
+    /**
+    get_nearest_point for many points against one orbit, split across the job pool.
+
+    @param nearest output, one entry per point
+    */
+    void get_nearest_points_batch(
+            const OrbitElements &elements,
+            const godot::Vector2 focus,
+            const int count,
+            const godot::Vector2 *positions,
+            const double time,
+            NearestPoint *nearest
+    );
+
+    /**
+    Lower bound of the distance from position to an orbit. The orbit lies in the annulus between its periapsis and
+    apoapsis distance around the focus, so no point of it is closer than the gap to that annulus.
+    */
+    float get_nearest_distance_lower_bound(
+            const OrbitElements &elements,
+            const godot::Vector2 focus,
+            const godot::Vector2 position
+    );
+
+    /**
+    The orbit passing closest to position among many, such as every orbit drawn on screen for hover picking.
+
+    Orbits are ruled out by get_nearest_distance_lower_bound first. The rest are solved in order of their bound,
+    stopping at the first bound beyond the best distance found, which usually leaves one or two exact solves
+    however many orbits there are.
+
+    @param elements elements of every orbit
+    @param foci focus of every orbit
+    @param mask orbits to consider, nullptr for all
+    @param position query point
+    @param max_distance orbits farther than this from position are not picked
+    @param time time the time of flight is measured from
+    @param nearest output, closest point of the orbit found
+    @return index of the closest orbit, -1 if none is within max_distance
+    */
+    int find_nearest_orbit(
+            const int count,
+            const OrbitElements *elements,
+            const godot::Vector2 *foci,
+            const char *mask,
+            const godot::Vector2 position,
+            const float max_distance,
+            const double time,
+            NearestPoint &nearest
+    );
+
+}
@@ -0,0 +1,156 @@
+#include <cfloat>
+#include <cmath>
+
+#include "job_pool.hpp"
+#include "orbit_index.hpp"
+#include "orbit_overlap.hpp"
+
+namespace orbits {
+
+    // Pairs per task handed to the job pool, a single query can already take hundreds of evaluations
+    static const int overlap_grain_size = 16;
+
+    namespace {
+        /**
+        Separation of two bodies minus radius, negative while they overlap. With a sign of -1 it is negative while
+        they are apart instead, so the same search finds when they come apart.
+        */
+        struct Clearance {
+            const OrbitElements &elements1;
+            const OrbitElements &elements2;
+            const godot::Vector2 focus1;
+            const godot::Vector2 focus2;
+            const double radius;
+            const double sign;
+
+            double operator()(const double time) const {
+                const godot::Vector2 p1 = get_heliocentric_position_velocity_from_time(time, elements1).p;
+                const godot::Vector2 p2 = get_heliocentric_position_velocity_from_time(time, elements2).p;
+                return sign * (((focus1 + p1) - (focus2 + p2)).length() - radius);
+            }
+        };
+
+        double get_periapsis_speed(const OrbitElements &elements) {
+            const double e = elements.eccentricity;
+            return elements.sqrt_mu_a / elements.semi_major_axis * std::sqrt((1.0 + e) / (1.0 - e));
+        }
+
+        /**
+        Earliest root of clearance in an interval where it is positive at a and not at b, by the Illinois
+        variant of regula falsi.
+        */
+        double solve_contact(const Clearance &clearance, double a, double b, double fa, double fb) {
+            int side = 0;
+            for (int iteration = 0; iteration < 32 && b - a > 1e-7 * (1.0 + std::abs(b)); iteration++) {
+                const double t = (a * fb - b * fa) / (fb - fa);
+                const double ft = clearance(t);
+                if (ft > 0.0) {
+                    a = t;
+                    fa = ft;
+                    if (side == -1) fb *= 0.5;
+                    side = -1;
+                } else {
+                    b = t;
+                    fb = ft;
+                    if (side == 1) fa *= 0.5;
+                    side = 1;
+                }
+            }
+            return b;
+        }
+
+        /**
+        Branch and bound over [a, b], earliest half first. fa and fb are the clearance at the ends.
+        */
+        double search(const Clearance &clearance, const double max_rate, const double tolerance,
+                      const double a, const double b, const double fa, const double fb) {
+            if (fa <= 0.0) return a;
+            // Lowest the clearance can get between a and b when it changes no faster than max_rate
+            if (0.5 * (fa + fb - max_rate * (b - a)) > 0.0) return INFINITY;
+
+            // Far from time 0 the spacing of doubles can exceed the tolerance, mid then rounds onto an end and the
+            // interval cannot be split any further
+            const double mid = 0.5 * (a + b);
+            if (b - a <= tolerance || mid <= a || mid >= b) {
+                if (fb <= 0.0) return solve_contact(clearance, a, b, fa, fb);
+                return clearance(mid) <= 0.0 ? mid : INFINITY;
+            }
+
+            const double fm = clearance(mid);
+            const double time = search(clearance, max_rate, tolerance, a, mid, fa, fm);
+            if (time != INFINITY) return time;
+            return search(clearance, max_rate, tolerance, mid, b, fm, fb);
+        }
+    }
+
+    double find_next_overlap_time(const OrbitElements &elements1, const godot::Vector2 focus1, const float radius1,
+                                  const OrbitElements &elements2, const godot::Vector2 focus2, const float radius2,
+                                  const double start, const double end, const double tolerance) {
+        if (!(end >= start)) return INFINITY;
+        if (elements1.eccentricity >= 1.0 || elements2.eccentricity >= 1.0) return INFINITY;
+
+        // Bodies whose periapsis-apoapsis annuli never meet cannot touch
+        if (!OrbitOverlapIndex::can_overlap(elements1, focus1, radius1, elements2, focus2, radius2)) return INFINITY;
+
+        const double radius = static_cast<double>(radius1) + radius2;
+        const Clearance clearance = {elements1, elements2, focus1, focus2, radius, 1.0};
+        const double max_rate = get_periapsis_speed(elements1) + get_periapsis_speed(elements2);
+        return search(clearance, max_rate, std::fmax(tolerance, 0.0), start, end, clearance(start), clearance(end));
+    }
+
+    double find_next_contact_time(const OrbitElements &elements1, const godot::Vector2 focus1, const float radius1,
+                                  const OrbitElements &elements2, const godot::Vector2 focus2, const float radius2,
+                                  const double start, const double end, const double tolerance) {
+        if (!(end >= start)) return INFINITY;
+        if (elements1.eccentricity >= 1.0 || elements2.eccentricity >= 1.0) return INFINITY;
+        if (!OrbitOverlapIndex::can_overlap(elements1, focus1, radius1, elements2, focus2, radius2)) return INFINITY;
+
+        const double radius = static_cast<double>(radius1) + radius2;
+        const double max_rate = get_periapsis_speed(elements1) + get_periapsis_speed(elements2);
+        const double resolution = std::fmax(tolerance, 0.0);
+        const Clearance clearance = {elements1, elements2, focus1, focus2, radius, 1.0};
+        double from = start;
+        double clearance_from = clearance(start);
+        if (clearance_from <= 0.0) {
+            // The bodies only count as apart again once they are clear by the distance the resolution allows
+            // for and by the float rounding of their positions, so a contact cannot end and begin again within
+            // the noise of the position
+            const double extent = elements1.semi_major_axis * (1.0 + elements1.eccentricity) + focus1.length()
+                    + elements2.semi_major_axis * (1.0 + elements2.eccentricity) + focus2.length();
+            const double margin = std::fmax(max_rate * resolution, 8.0 * FLT_EPSILON * extent);
+            const Clearance overlap = {elements1, elements2, focus1, focus2, radius + margin, -1.0};
+            from = search(overlap, max_rate, resolution, start, end, overlap(start), overlap(end));
+            if (from == INFINITY) return INFINITY;
+            clearance_from = clearance(from);
+            if (!(clearance_from > 0.0)) return INFINITY;
+        }
+        return search(clearance, max_rate, resolution, from, end, clearance_from, clearance(end));
+    }
+
+    void find_next_overlap_time_batch(const int pair_count, const int *pairs, const OrbitElements *elements,
+                                      const godot::Vector2 *foci, const float *radii, const double start,
+                                      const double end, const double tolerance, double *times) {
+        jobs::JobPool::get_singleton().parallel_for(pair_count, overlap_grain_size, [=](int begin, int stop) {
+            for (int k = begin; k < stop; k++) {
+                const int i = pairs[2 * k];
+                const int j = pairs[2 * k + 1];
+                times[k] = find_next_overlap_time(elements[i], foci[i], radii[i], elements[j], foci[j], radii[j],
+                                                  start, end, tolerance);
+            }
+        });
+    }
+
+    void find_next_contact_time_batch(const int pair_count, const int *pairs, const OrbitElements *elements,
+                                      const godot::Vector2 *foci, const float *radii, const double start,
+                                      const double end, const double tolerance, double *times) {
+        jobs::JobPool::get_singleton().parallel_for(pair_count, overlap_grain_size, [=](int begin, int stop) {
+            for (int k = begin; k < stop; k++) {
+                const int i = pairs[2 * k];
+                const int j = pairs[2 * k + 1];
+                times[k] = find_next_contact_time(elements[i], foci[i], radii[i], elements[j], foci[j], radii[j],
+                                                  start, end, tolerance);
+            }
+        });
+    }
+
+}
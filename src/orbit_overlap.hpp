@@ -0,0 +1,111 @@
+#pragma once
+
+#include <Godot.hpp>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    Finds the earliest time in [start, end] at which two bodies on elliptic orbits, seen as circles, touch.
+
+    The separation of the bodies changes no faster than the sum of their periapsis speeds, which bounds it from
+    below over any interval from its values at the two ends. The window is bisected earliest half first and every
+    interval whose bound stays above radius1 + radius2 is discarded, so the solver spends its evaluations around
+    close approaches only and cannot step over a short contact the way fixed step sampling does. The interval
+    containing the first contact is then solved to full precision by regula falsi.
+
+    @param elements1 the orbit of the first body
+    @param focus1 position of the focus of the first orbit
+    @param radius1 radius of the first body
+    @param elements2 the orbit of the second body
+    @param focus2 position of the focus of the second orbit
+    @param radius2 radius of the second body
+    @param start beginning of the search window
+    @param end end of the search window
+    @param tolerance width below which an interval is no longer split, close approaches that stay apart by less
+           than the distance covered in this time may be reported as contact
+    @return the time of first contact, start if the bodies already overlap, or infinity if they do not touch
+    */
+    double find_next_overlap_time(
+            const OrbitElements &elements1,
+            const godot::Vector2 focus1,
+            const float radius1,
+            const OrbitElements &elements2,
+            const godot::Vector2 focus2,
+            const float radius2,
+            const double start,
+            const double end,
+            const double tolerance
+    );
+
+    /**
+    Like find_next_overlap_time, but only the start of a contact counts. Bodies that already overlap at start are
+    followed until they come apart first, so searching again from the time of a contact finds the next contact
+    and not the same one.
+
+    @return the earliest time after start at which the bodies come into contact, or infinity if they do not
+    */
+    double find_next_contact_time(
+            const OrbitElements &elements1,
+            const godot::Vector2 focus1,
+            const float radius1,
+            const OrbitElements &elements2,
+            const godot::Vector2 focus2,
+            const float radius2,
+            const double start,
+            const double end,
+            const double tolerance
+    );
+
+    /**
+    find_next_overlap_time for many pairs of bodies at once, split across the job pool.
+
+    @param pair_count number of pairs
+    @param pairs indices of the two bodies of each pair, flattened as [i0, j0, i1, j1, ...]
+    @param elements orbit of each body
+    @param foci focus of each body's orbit
+    @param radii radius of each body
+    @param start beginning of the search window
+    @param end end of the search window
+    @param tolerance see find_next_overlap_time
+    @param times output, time of first contact of each pair, infinity when none
+    */
+    void find_next_overlap_time_batch(
+            const int pair_count,
+            const int *pairs,
+            const OrbitElements *elements,
+            const godot::Vector2 *foci,
+            const float *radii,
+            const double start,
+            const double end,
+            const double tolerance,
+            double *times
+    );
+
+    /**
+    find_next_contact_time for many pairs of bodies at once, split across the job pool.
+
+    @param pair_count number of pairs
+    @param pairs indices of the two bodies of each pair, flattened as [i0, j0, i1, j1, ...]
+    @param elements orbit of each body
+    @param foci focus of each body's orbit
+    @param radii radius of each body
+    @param start beginning of the search window
+    @param end end of the search window
+    @param tolerance see find_next_overlap_time
+    @param times output, time of the next contact of each pair, infinity when none
+    */
+    void find_next_contact_time_batch(
+            const int pair_count,
+            const int *pairs,
+            const OrbitElements *elements,
+            const godot::Vector2 *foci,
+            const float *radii,
+            const double start,
+            const double end,
+            const double tolerance,
+            double *times
+    );
+
+}
@@ -0,0 +1,144 @@
+#include <cmath>
+
+#include "job_pool.hpp"
+#include "orbit_soi.hpp"
+
+namespace orbits {
+
+    // Points per task handed to the job pool, each one a few hash lookups per level
+    static const int query_grain_size = 256;
+
+    // Cell coordinates are clamped to this so points far out on the finest levels cannot overflow them
+    static const double max_cell_coordinate = 4.0e18;
+
+    size_t SphereOfInfluenceIndex::CellHash::operator()(const Cell &cell) const {
+        uint64_t h = static_cast<uint64_t>(cell.x) * 0x9E3779B97F4A7C15ull;
+        h ^= static_cast<uint64_t>(cell.y) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+        h ^= static_cast<uint64_t>(cell.level) + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        return static_cast<size_t>(h);
+    }
+
+    SphereOfInfluenceIndex::SphereOfInfluenceIndex() {
+        clear();
+    }
+
+    void SphereOfInfluenceIndex::resize(const int count) {
+        for (int i = count; i < get_count(); i++) {
+            erase(i);
+        }
+        Sphere empty;
+        empty.radius = 0.0f;
+        empty.depth = 0;
+        empty.cell.level = -1;
+        empty.slot = -1;
+        spheres.resize(count, empty);
+    }
+
+    int SphereOfInfluenceIndex::get_count() const {
+        return static_cast<int>(spheres.size());
+    }
+
+    void SphereOfInfluenceIndex::clear() {
+        spheres.clear();
+        cells.clear();
+        for (int level = 0; level < level_count; level++) {
+            level_sizes[level] = 0;
+        }
+    }
+
+    void SphereOfInfluenceIndex::set(const int index, const godot::Vector2 center, const float radius,
+                                     const int depth) {
+        erase(index);
+        Sphere &sphere = spheres[index];
+        sphere.center = center;
+        sphere.radius = radius > 0.0f ? radius : 0.0f;
+        sphere.depth = depth;
+        if (sphere.radius > 0.0f) insert(index);
+    }
+
+    void SphereOfInfluenceIndex::move(const int index, const godot::Vector2 center) {
+        Sphere &sphere = spheres[index];
+        sphere.center = center;
+        if (sphere.cell.level < 0) return;
+        if (get_cell(sphere.cell.level, center) == sphere.cell) return;
+        erase(index);
+        insert(index);
+    }
+
+    int SphereOfInfluenceIndex::find(const godot::Vector2 point) const {
+        int best = -1;
+        for (int level = 0; level < level_count; level++) {
+            if (level_sizes[level] == 0) continue;
+            const Cell center = get_cell(level, point);
+            for (int dy = -1; dy <= 1; dy++) {
+                for (int dx = -1; dx <= 1; dx++) {
+                    const auto cell = cells.find(Cell{level, center.x + dx, center.y + dy});
+                    if (cell == cells.end()) continue;
+                    for (const int i : cell->second) {
+                        const Sphere &sphere = spheres[i];
+                        if ((point - sphere.center).length_squared() > sphere.radius * sphere.radius) continue;
+                        if (best < 0 || sphere.depth > spheres[best].depth
+                                || (sphere.depth == spheres[best].depth && sphere.radius < spheres[best].radius)) {
+                            best = i;
+                        }
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    void SphereOfInfluenceIndex::find_batch(const int count, const godot::Vector2 *points, int *found) const {
+        jobs::JobPool::get_singleton().parallel_for(count, query_grain_size, [=](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                found[k] = find(points[k]);
+            }
+        });
+    }
+
+    int SphereOfInfluenceIndex::get_level(const float radius) {
+        // Smallest power of two cell size no narrower than the sphere
+        int exponent;
+        const double mantissa = std::frexp(2.0 * radius, &exponent);
+        const int level = (mantissa == 0.5 ? exponent - 1 : exponent) + level_offset;
+        return level < 0 ? 0 : (level >= level_count ? level_count - 1 : level);
+    }
+
+    SphereOfInfluenceIndex::Cell SphereOfInfluenceIndex::get_cell(const int level, const godot::Vector2 point) {
+        const double x = std::floor(std::ldexp(static_cast<double>(point.x), level_offset - level));
+        const double y = std::floor(std::ldexp(static_cast<double>(point.y), level_offset - level));
+        return Cell{
+                level,
+                static_cast<int64_t>(std::fmax(-max_cell_coordinate, std::fmin(max_cell_coordinate, x))),
+                static_cast<int64_t>(std::fmax(-max_cell_coordinate, std::fmin(max_cell_coordinate, y)))
+        };
+    }
+
+    void SphereOfInfluenceIndex::insert(const int index) {
+        Sphere &sphere = spheres[index];
+        sphere.cell = get_cell(get_level(sphere.radius), sphere.center);
+        std::vector<int> &list = cells[sphere.cell];
+        sphere.slot = static_cast<int>(list.size());
+        list.push_back(index);
+        level_sizes[sphere.cell.level]++;
+    }
+
+    void SphereOfInfluenceIndex::erase(const int index) {
+        Sphere &sphere = spheres[index];
+        if (sphere.cell.level < 0) return;
+
+        // Swap the last sphere of the cell into the freed slot, and drop cells that run empty
+        const auto cell = cells.find(sphere.cell);
+        std::vector<int> &list = cell->second;
+        const int last = list.back();
+        list[sphere.slot] = last;
+        spheres[last].slot = sphere.slot;
+        list.pop_back();
+        if (list.empty()) cells.erase(cell);
+
+        level_sizes[sphere.cell.level]--;
+        sphere.cell.level = -1;
+        sphere.slot = -1;
+    }
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <Godot.hpp>
+
+namespace orbits {
+
+    /**
+    Answers which sphere of influence a point is in, for many points against the spheres of many moving bodies.
+
+    The spheres are kept in a hierarchical grid: a grid per power of two cell size, every sphere stored in the cell
+    containing its center on the finest level whose cells are at least as wide as the sphere. A sphere can then
+    only contain points of that cell and its 8 neighbours, so a query looks at 9 cells on every level that holds a
+    sphere. Radii from moons to planets span a handful of levels, which keeps a query at O(log N) however many
+    spheres there are, and moving a sphere only touches the grid when its center crosses into another cell.
+    */
+    class SphereOfInfluenceIndex {
+    public:
+        SphereOfInfluenceIndex();
+
+        /**
+        Sizes the index for count spheres, new ones empty until set.
+        */
+        void resize(const int count);
+
+        int get_count() const;
+
+        void clear();
+
+        /**
+        @param index the sphere, usually the index of the body it belongs to
+        @param center position of the body
+        @param radius radius of the sphere, 0 for bodies without one
+        @param depth nesting depth of the body, the deepest of several spheres containing a point wins
+        */
+        void set(const int index, const godot::Vector2 center, const float radius, const int depth);
+
+        /**
+        Moves a sphere, only touching the grid when its center crosses into another cell.
+        */
+        void move(const int index, const godot::Vector2 center);
+
+        /**
+        @return the deepest sphere containing point, the smallest one between spheres of equal depth, -1 if point is
+                in none
+        */
+        int find(const godot::Vector2 point) const;
+
+        /**
+        find for every point, split across the job pool.
+        */
+        void find_batch(const int count, const godot::Vector2 *points, int *found) const;
+
+    private:
+        // Cells of level l are 2^(l - level_offset) wide
+        static const int level_offset = 32;
+        static const int level_count = 96;
+
+        struct Cell {
+            int level;
+            int64_t x;
+            int64_t y;
+
+            bool operator==(const Cell &other) const {
+                return level == other.level && x == other.x && y == other.y;
+            }
+        };
+
+        struct CellHash {
+            size_t operator()(const Cell &cell) const;
+        };
+
+        struct Sphere {
+            godot::Vector2 center;
+            float radius;
+            int depth;
+            Cell cell;  // level is -1 while the sphere is not in the grid
+            int slot;   // position in the list of its cell
+        };
+
+        static int get_level(const float radius);
+
+        static Cell get_cell(const int level, const godot::Vector2 point);
+
+        void insert(const int index);
+
+        void erase(const int index);
+
+        std::vector<Sphere> spheres;
+        std::unordered_map<Cell, std::vector<int>, CellHash> cells;
+        int level_sizes[level_count];  // number of spheres on every level
+    };
+
+}
@@ -0,0 +1,133 @@
+#include "job_pool.hpp"
+#include "orbit_store.hpp"
+
+namespace orbits {
+
+    // Orbits per task handed to the job pool
+    static const int store_grain_size = 1024;
+
+    namespace {
+        PositionVelocity2D get_position_velocity(const double time, const OrbitRecord &record) {
+            const OrbitElements elements = get_orbit_elements(record.eccentricity, record.semi_major_axis,
+                                                              record.argument_of_periapsis,
+                                                              record.standard_gravitational_parameter, record.epoch,
+                                                              record.mean_anomaly_at_epoch);
+            return get_heliocentric_position_velocity_from_time(time, elements);
+        }
+    }
+
+    bool OrbitStore::is_valid_record(const OrbitRecord &record) {
+        return record.semi_major_axis > 0.0f && record.eccentricity >= 0.0f && record.eccentricity < 1.0f;
+    }
+
+    int OrbitStore::create(const OrbitRecord &record) {
+        if (!is_valid_record(record)) return -1;
+        int slot;
+        if (free_slots.empty()) {
+            if (slot_indices.size() >= (1u << slot_bits)) return -1;
+            slot = static_cast<int>(slot_indices.size());
+            slot_indices.push_back(-1);
+            generations.push_back(0);
+        } else {
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        const int handle = (generations[slot] << slot_bits) | slot;
+        slot_indices[slot] = static_cast<int>(records.size());
+        records.push_back(record);
+        handles.push_back(handle);
+        return handle;
+    }
+
+    bool OrbitStore::update(const int handle, const OrbitRecord &record) {
+        const int index = get_index(handle);
+        if (index < 0 || !is_valid_record(record)) return false;
+        records[index] = record;
+        return true;
+    }
+
+    bool OrbitStore::destroy(const int handle) {
+        const int index = get_index(handle);
+        if (index < 0) return false;
+
+        // Move the last record into the hole so the dense array stays packed
+        const int last = static_cast<int>(records.size()) - 1;
+        records[index] = records[last];
+        handles[index] = handles[last];
+        slot_indices[handles[index] & ((1 << slot_bits) - 1)] = index;
+        records.pop_back();
+        handles.pop_back();
+
+        const int slot = handle & ((1 << slot_bits) - 1);
+        slot_indices[slot] = -1;
+        generations[slot] = (generations[slot] + 1) & generation_mask;
+        free_slots.push_back(slot);
+        return true;
+    }
+
+    bool OrbitStore::is_valid(const int handle) const {
+        return get_index(handle) >= 0;
+    }
+
+    void OrbitStore::clear() {
+        // Slots stay allocated with bumped generations, handed out before this still have to fail
+        while (!handles.empty()) {
+            destroy(handles.back());
+        }
+    }
+
+    int OrbitStore::get_count() const {
+        return static_cast<int>(records.size());
+    }
+
+    const OrbitRecord &OrbitStore::get(const int handle) const {
+        return records[get_index(handle)];
+    }
+
+    int OrbitStore::get_handle(const int index) const {
+        return handles[index];
+    }
+
+    void OrbitStore::get_position_velocity_batch(const int count, const int *handles, const double time,
+                                                 godot::Vector2 *positions, godot::Vector2 *velocities) const {
+        jobs::JobPool::get_singleton().parallel_for(count, store_grain_size, [=](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                const int index = handles ? get_index(handles[k]) : k;
+                const PositionVelocity2D pv = get_position_velocity(time, records[index]);
+                positions[k] = pv.p;
+                if (velocities) velocities[k] = pv.v;
+            }
+        });
+    }
+
+    void OrbitStore::find_in_rect(const godot::Vector2 low, const godot::Vector2 high, const double time,
+                                  std::vector<int> &found) const {
+        // Every task collects into its own list, joined in task order afterwards
+        const int count = get_count();
+        std::vector<std::vector<int>> chunks((count + store_grain_size - 1) / store_grain_size);
+        std::vector<int> *lists = chunks.data();
+        jobs::JobPool::get_singleton().parallel_for(count, store_grain_size, [=](int begin, int end) {
+            std::vector<int> &list = lists[begin / store_grain_size];
+            for (int index = begin; index < end; index++) {
+                const godot::Vector2 p = get_position_velocity(time, records[index]).p;
+                if (p.x >= low.x && p.y >= low.y && p.x <= high.x && p.y <= high.y) {
+                    list.push_back(handles[index]);
+                }
+            }
+        });
+
+        found.clear();
+        for (const std::vector<int> &list : chunks) {
+            found.insert(found.end(), list.begin(), list.end());
+        }
+    }
+
+    int OrbitStore::get_index(const int handle) const {
+        if (handle < 0) return -1;
+        const int slot = handle & ((1 << slot_bits) - 1);
+        if (slot >= static_cast<int>(slot_indices.size())) return -1;
+        if ((handle >> slot_bits) != generations[slot]) return -1;
+        return slot_indices[slot];
+    }
+
+}
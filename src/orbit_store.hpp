@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vector>
+
+#include <Godot.hpp>
+
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    The defining elements of an orbit and nothing derived from them, 32 bytes.
+    */
+    struct OrbitRecord {
+        float eccentricity;
+        float semi_major_axis;
+        float argument_of_periapsis;
+        float standard_gravitational_parameter;
+        double epoch;
+        double mean_anomaly_at_epoch;
+    };
+
+    /**
+    Orbits addressed by integer handles, for very many bodies that have no node of their own.
+
+    The records are packed in one dense array that bulk queries sweep over, and a handle names a slot that points
+    into it. Freeing an orbit moves the last record into its place and puts the slot on a free list, so the array
+    never has holes. Every slot carries a generation that is part of its handle, so a freed handle stays invalid
+    through the next 127 reuses of its slot.
+
+    Only the records are stored, about 41 bytes per orbit with the handle bookkeeping, where an OrbitElements is
+    twice the size of a record. The rest of the elements are derived again on every query.
+    */
+    class OrbitStore {
+    public:
+        /**
+        @return whether record is an ellipse, a positive semi-major axis and an eccentricity in [0, 1). Elements
+                derived from anything else come back nan from every query.
+        */
+        static bool is_valid_record(const OrbitRecord &record);
+
+        /**
+        @return handle of the new orbit, -1 if record is not valid or once 2^24 slots are in use
+        */
+        int create(const OrbitRecord &record);
+
+        /**
+        @return false if handle or record is not valid
+        */
+        bool update(const int handle, const OrbitRecord &record);
+
+        /**
+        @return false if handle is not valid
+        */
+        bool destroy(const int handle);
+
+        bool is_valid(const int handle) const;
+
+        void clear();
+
+        int get_count() const;
+
+        /**
+        @param handle a valid handle
+        */
+        const OrbitRecord &get(const int handle) const;
+
+        /**
+        @return handle of the orbit at index in the dense order bulk queries return results in
+        */
+        int get_handle(const int index) const;
+
+        /**
+        Positions and velocities of count orbits at time, relative to their focus, split across the job pool.
+
+        @param handles valid handles, nullptr for all orbits in dense order
+        @param velocities output, nullptr if not needed
+        */
+        void get_position_velocity_batch(const int count, const int *handles, const double time,
+                                         godot::Vector2 *positions, godot::Vector2 *velocities) const;
+
+        /**
+        Handles of every orbit whose body is inside the rectangle from low to high at time, in dense order, for
+        picking the orbits that should be backed by nodes.
+        */
+        void find_in_rect(const godot::Vector2 low, const godot::Vector2 high, const double time,
+                          std::vector<int> &found) const;
+
+    private:
+        // A handle is the slot in its low bits and the slot's generation above them, so it stays a positive int
+        static const int slot_bits = 24;
+        static const int generation_mask = 0x7f;
+
+        int get_index(const int handle) const;
+
+        std::vector<OrbitRecord> records;
+        std::vector<int> handles;         // handle of every record
+        std::vector<int> slot_indices;    // record index of every slot, -1 for free slots
+        std::vector<unsigned char> generations;
+        std::vector<int> free_slots;
+    };
+
+}
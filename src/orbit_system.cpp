@@ -0,0 +1,926 @@
+#include <algorithm>
+
+#include "job_pool.hpp"
+#include "kepler.hpp"
+#include "orbit_overlap.hpp"
+#include "orbit_system.hpp"
+#include "stats.hpp"
+
+using godot::Vector2;
+
+namespace orbits {
+
+    // Bodies per task handed to the job pool, large enough to amortize the scheduling cost
+    static const int propagation_grain_size = 1024;
+
+    // Resolution of find_next_overlap_times as a fraction of the searched duration
+    static const float overlap_tolerance_fraction = 1.0 / 65536.0;
+
+    // Resolution of scheduled contacts as a fraction of the event horizon
+    static const float event_tolerance_fraction = 1.0 / 65536.0;
+
+    OrbitSystem::OrbitSystem() :
+            standard_gravitational_parameter(1.0),
+            time(0.0),
+            kepler_table_enabled(false),
+            kepler_table_refine(false),
+            soi_radius(0.0),
+            event_horizon(10.0),
+            integrator_step_fraction(0.01),
+            nbody_opening_angle(0.5),
+            nbody_softening(0.0),
+            hierarchy_dirty(true),
+            body_tables_dirty(true),
+            overlap_index_dirty(true),
+            soi_index_dirty(true),
+            free_bodies_dirty(true),
+            integrated_time(0.0),
+            collision_search_end(0.0),
+            events_dirty(true) {}
+
+    bool OrbitSystem::is_valid_orbit(const float eccentricity, const float semi_major_axis) {
+        return semi_major_axis > 0.0f && eccentricity >= 0.0f && eccentricity < 1.0f;
+    }
+
+    void OrbitSystem::update_overlap_index() {
+        if (!overlap_index_dirty) return;
+        overlap_index.clear();
+        for (int i = 0; i < static_cast<int>(elements.size()); i++) {
+            overlap_index.add(elements[i], Vector2(), radii[i]);
+        }
+        overlap_index_dirty = false;
+    }
+
+    void OrbitSystem::update_hierarchy() {
+        if (!hierarchy_dirty) return;
+        // set_body_parent refuses cycles, so this cannot fail
+        hierarchy.build(static_cast<int>(parents.size()), parents.data());
+        hierarchy_dirty = false;
+    }
+
+    void OrbitSystem::update_soi_index(const Vector2 *body_positions) {
+        if (!soi_index_dirty) {
+            for (const int i : soi_bodies) {
+                soi_index.move(i, body_positions[i]);
+            }
+            return;
+        }
+        const int count = static_cast<int>(elements.size());
+        soi_index.clear();
+        soi_index.resize(count);
+        soi_bodies.clear();
+        update_hierarchy();
+        for (int i = 0; i < count; i++) {
+            const float primary = get_primary_gravitational_parameter(i);
+            if (body_gravitational_parameters[i] <= 0.0 || primary <= 0.0) continue;
+            const float radius = get_sphere_of_influence_radius(elements[i].semi_major_axis,
+                                                                body_gravitational_parameters[i], primary);
+            soi_index.set(i, body_positions[i], radius, hierarchy.get_depth(i));
+            soi_bodies.push_back(i);
+        }
+        soi_index_dirty = false;
+    }
+
+    float OrbitSystem::get_primary_gravitational_parameter(const int index) const {
+        return parents[index] < 0 ? standard_gravitational_parameter : body_gravitational_parameters[parents[index]];
+    }
+
+    void OrbitSystem::rebuild_elements(const int index) {
+        const OrbitElements &old = elements[index];
+        elements[index] = get_orbit_elements(old.eccentricity, old.semi_major_axis, old.argument_of_periapsis,
+                                             get_primary_gravitational_parameter(index), old.epoch,
+                                             old.mean_anomaly_at_epoch);
+    }
+
+    void OrbitSystem::schedule_events() {
+        const int count = static_cast<int>(elements.size());
+        events.reset(count);
+        for (int i = 0; i < count; i++) {
+            push_body_events(i, time);
+        }
+        update_collision_pairs();
+        collision_search_end = time;
+        event_bodies.clear();
+        // Bodies an earlier event of the same step touched still have to be propagated at its end
+        touched.resize(count, 0);
+        events_dirty = false;
+    }
+
+    void OrbitSystem::schedule_collisions(const double end) {
+        // Contacts are searched one event horizon at a time, each pair reports its first contact in every window
+        const double window = event_horizon > 0.0 ? event_horizon : end - collision_search_end;
+        while (collision_search_end < end && !collision_pairs.empty()) {
+            const double start = collision_search_end;
+            push_collisions(collision_pairs, start, start + window);
+            collision_search_end = start + window;
+        }
+    }
+
+    void OrbitSystem::invalidate_events(const int index) {
+        if (events_dirty) return;
+        // Once every body would be rescheduled anyway, rescheduling them all at once is no more work
+        if (event_bodies.size() >= elements.size()) {
+            event_bodies.clear();
+            events_dirty = true;
+            return;
+        }
+        event_bodies.push_back(index);
+    }
+
+    void OrbitSystem::reschedule_body_events(const double from) {
+        // Only the bodies that changed lose their pending events, and their new ones come strictly after from, so
+        // an event handler that changes a body does not get the event it is handling again
+        const int count = static_cast<int>(elements.size());
+        std::vector<char> changed(count, 0);
+        for (const int i : event_bodies) {
+            if (changed[i]) continue;
+            changed[i] = 1;
+            events.invalidate(i);
+            push_body_events(i, from);
+        }
+        event_bodies.clear();
+
+        // Pairs with a changed body are searched again up to where the other pairs have been searched
+        update_collision_pairs();
+        if (!(collision_search_end > from)) return;
+        std::vector<int> pairs;
+        for (int k = 0; k < static_cast<int>(collision_pairs.size()); k += 2) {
+            if (changed[collision_pairs[k]] || changed[collision_pairs[k + 1]]) {
+                pairs.push_back(collision_pairs[k]);
+                pairs.push_back(collision_pairs[k + 1]);
+            }
+        }
+        push_collisions(pairs, from, collision_search_end);
+    }
+
+    void OrbitSystem::push_body_events(const int index, const double from) {
+        // Bodies off rails have no orbit to foresee events on
+        if (off_rails[index]) return;
+        events.push({get_next_periapsis_time(from, elements[index]), ORBIT_EVENT_PERIAPSIS, index, -1});
+        // soi_radius is the sphere of influence of the primary at the origin
+        if (soi_radius > 0.0 && parents[index] < 0) {
+            const double exit_time = get_next_soi_exit_time(from, elements[index], soi_radius);
+            if (exit_time != INFINITY) events.push({exit_time, ORBIT_EVENT_SOI_EXIT, index, -1});
+        }
+    }
+
+    void OrbitSystem::update_collision_pairs() {
+        // Only bodies with a radius take part in contacts, and only pairs the overlap index cannot rule out.
+        // Contacts are searched between bodies orbiting the same focus, whose separation does not depend on where
+        // it is.
+        collision_pairs.clear();
+        update_overlap_index();
+        std::vector<std::pair<int, int>> candidates;
+        overlap_index.find_candidate_pairs(candidates);
+        for (const std::pair<int, int> &pair : candidates) {
+            if (radii[pair.first] > 0.0 && radii[pair.second] > 0.0 && parents[pair.first] == parents[pair.second]
+                    && !off_rails[pair.first] && !off_rails[pair.second]) {
+                collision_pairs.push_back(pair.first);
+                collision_pairs.push_back(pair.second);
+            }
+        }
+    }
+
+    void OrbitSystem::push_collisions(const std::vector<int> &pairs, const double start, const double end) {
+        // Pairs already in contact at start were reported when the contact began, they are skipped until they part
+        const int pair_count = static_cast<int>(pairs.size()) / 2;
+        if (pair_count == 0) return;
+        std::vector<Vector2> foci(elements.size());
+        std::vector<double> times(pair_count);
+        find_next_contact_time_batch(pair_count, pairs.data(), elements.data(), foci.data(), radii.data(), start,
+                                     end, (end - start) * event_tolerance_fraction, times.data());
+        for (int k = 0; k < pair_count; k++) {
+            if (times[k] != INFINITY) {
+                events.push({times[k], ORBIT_EVENT_COLLISION, pairs[2 * k], pairs[2 * k + 1]});
+            }
+        }
+    }
+
+    void OrbitSystem::propagate_bodies(const std::vector<int> &bodies, const char *mask) {
+        stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+        const int count = static_cast<int>(elements.size());
+        positions.resize(count);
+        velocities.resize(count);
+        integrate_free_bodies();
+        if (bodies.empty()) return;
+        stats::add_bodies_propagated(static_cast<int>(bodies.size()));
+
+        Vector2 *p = positions.data();
+        Vector2 *v = velocities.data();
+        const int *indices = bodies.data();
+        const OrbitElements *body_elements = elements.data();
+        const double now = time;
+
+        jobs::JobPool::get_singleton().parallel_for(static_cast<int>(bodies.size()), propagation_grain_size,
+                                                    [=](int begin, int end) {
+            for (int k = begin; k < end; k++) {
+                const int i = indices[k];
+                const PositionVelocity2D pv = get_heliocentric_position_velocity_from_time(now, body_elements[i]);
+                p[i] = pv.p;
+                v[i] = pv.v;
+            }
+        });
+        for (const int i : free_bodies) {
+            p[i] = Vector2(states[i].x, states[i].y);
+            v[i] = Vector2(states[i].vx, states[i].vy);
+        }
+
+        update_hierarchy();
+        if (hierarchy.is_nested()) hierarchy.accumulate(p, v, mask);
+        update_soi_index(p);
+    }
+
+    void OrbitSystem::integrate_free_bodies() {
+        const int count = static_cast<int>(elements.size());
+        if (free_bodies_dirty) {
+            free_bodies.clear();
+            for (int i = 0; i < count; i++) {
+                if (off_rails[i]) free_bodies.push_back(i);
+            }
+            free_bodies_dirty = false;
+        }
+        const double duration = time - integrated_time;
+        integrated_time = time;
+        if (free_bodies.empty() || duration == 0.0) return;
+
+        // Gathered into packed arrays, the batch then runs over contiguous memory
+        const int free_count = static_cast<int>(free_bodies.size());
+        std::vector<StateVector2D> free_states(free_count);
+        std::vector<double> gravitational_parameters(free_count);
+        std::vector<Vector2> accelerations(free_count);
+        for (int k = 0; k < free_count; k++) {
+            const int i = free_bodies[k];
+            free_states[k] = states[i];
+            gravitational_parameters[k] = get_primary_gravitational_parameter(i);
+            accelerations[k] = thrusts[i];
+        }
+        add_perturbations(accelerations);
+
+        // Bodies feeling nothing but their primary are on a conic, escape trajectories included, and follow it
+        // exactly in the universal variable kernel. Only the others need integration steps.
+        std::vector<int> coasting;
+        std::vector<StateVector2D> coasting_states;
+        std::vector<double> coasting_gravitational_parameters;
+        int integrated_count = 0;
+        for (int k = 0; k < free_count; k++) {
+            if (accelerations[k] == Vector2() && !perturbed[free_bodies[k]]) {
+                coasting.push_back(free_bodies[k]);
+                coasting_states.push_back(free_states[k]);
+                coasting_gravitational_parameters.push_back(gravitational_parameters[k]);
+                continue;
+            }
+            free_bodies[integrated_count] = free_bodies[k];
+            free_states[integrated_count] = free_states[k];
+            gravitational_parameters[integrated_count] = gravitational_parameters[k];
+            accelerations[integrated_count] = accelerations[k];
+            integrated_count++;
+        }
+        integrate_leapfrog_batch(integrated_count, free_states.data(), gravitational_parameters.data(),
+                                 accelerations.data(), duration, integrator_step_fraction);
+        propagate_universal_batch(static_cast<int>(coasting.size()), coasting_states.data(),
+                                  coasting_gravitational_parameters.data(), duration);
+        for (int k = 0; k < integrated_count; k++) {
+            states[free_bodies[k]] = free_states[k];
+        }
+        for (int k = 0; k < static_cast<int>(coasting.size()); k++) {
+            states[coasting[k]] = coasting_states[k];
+            free_bodies[integrated_count + k] = coasting[k];
+        }
+
+        // Coasting bodies go back on rails as soon as they are on an orbit the elements can describe
+        free_bodies.erase(std::remove_if(free_bodies.begin(), free_bodies.end(), [this](const int i) {
+            return thrusts[i] == Vector2() && !perturbed[i] && return_to_rails(i);
+        }), free_bodies.end());
+    }
+
+    void OrbitSystem::add_perturbations(std::vector<Vector2> &accelerations) {
+        // Sources and targets where the last propagation left them, which is where this step starts
+        const int count = static_cast<int>(elements.size());
+        if (static_cast<int>(positions.size()) != count) return;
+
+        // Every perturbed body is queried at its own position, and at its parent's unless it orbits the origin
+        std::vector<Vector2> points;
+        std::vector<int> ignore;
+        std::vector<int> slots;
+        for (int k = 0; k < static_cast<int>(free_bodies.size()); k++) {
+            const int i = free_bodies[k];
+            if (!perturbed[i]) continue;
+            slots.push_back(k);
+            points.push_back(positions[i]);
+            ignore.push_back(i);
+            if (parents[i] < 0) continue;
+            points.push_back(positions[parents[i]]);
+            ignore.push_back(parents[i]);
+        }
+        if (slots.empty()) return;
+
+        nbody_tree.build(count, positions.data(), body_gravitational_parameters.data());
+        std::vector<Vector2> pulls(points.size());
+        nbody_tree.get_acceleration_batch(static_cast<int>(points.size()), points.data(), ignore.data(),
+                                          nbody_opening_angle, nbody_softening, pulls.data());
+
+        // The state is relative to the parent, which is pulled on as well, so only the difference bends the orbit.
+        // The parent's own pull is the Kepler term of the integrator already.
+        const float softening2 = nbody_softening * nbody_softening;
+        int query = 0;
+        for (const int k : slots) {
+            const int i = free_bodies[k];
+            const int parent = parents[i];
+            Vector2 perturbation = pulls[query++];
+            if (parent >= 0) {
+                const Vector2 offset = positions[parent] - positions[i];
+                const float distance2 = offset.length_squared() + softening2;
+                perturbation -= offset * (body_gravitational_parameters[parent] / (distance2 * std::sqrt(distance2)));
+                perturbation -= pulls[query++];
+            }
+            accelerations[k] += perturbation;
+        }
+    }
+
+    bool OrbitSystem::return_to_rails(const int index) {
+        const StateVector2D &state = states[index];
+        if (!get_orbit_elements_from_state(Vector2(state.x, state.y), Vector2(state.vx, state.vy),
+                                           get_primary_gravitational_parameter(index), integrated_time,
+                                           elements[index])) {
+            return false;
+        }
+        off_rails[index] = 0;
+        body_tables_dirty = true;
+        overlap_index_dirty = true;
+        soi_index_dirty = true;
+        invalidate_events(index);
+        return true;
+    }
+
+    void OrbitSystem::leave_rails(const int index) {
+        if (off_rails[index]) return;
+        const PositionVelocity2D pv = get_heliocentric_position_velocity_from_time(time, elements[index]);
+        states[index] = StateVector2D{pv.p.x, pv.p.y, pv.v.x, pv.v.y};
+        off_rails[index] = 1;
+        free_bodies_dirty = true;
+        invalidate_events(index);
+    }
+
+    void OrbitSystem::propagate() {
+        stats::ScopedTimer timer(stats::TIMER_PROPAGATION);
+        const int count = static_cast<int>(elements.size());
+        positions.resize(count);
+        velocities.resize(count);
+        if (count == 0) return;
+        stats::add_bodies_propagated(count);
+        integrate_free_bodies();
+
+        // Every task writes its slice straight into the output arrays
+        Vector2 *p = positions.data();
+        Vector2 *v = velocities.data();
+        const OrbitElements *body_elements = elements.data();
+        const double now = time;
+
+        if (kepler_table_enabled) {
+            if (body_tables_dirty) {
+                // Bodies whose table did not fit in the budget keep a null entry and use the solver
+                body_tables.resize(count);
+                for (int i = 0; i < count; i++) {
+                    body_tables[i] = kepler_tables.get(elements[i].eccentricity);
+                }
+                body_tables_dirty = false;
+            }
+            const kepler::EccAnomalyTable *const *tables = body_tables.data();
+            const bool refine = kepler_table_refine;
+
+            jobs::JobPool::get_singleton().parallel_for(count, propagation_grain_size, [=](int begin, int end) {
+                for (int i = begin; i < end; i++) {
+                    const double mean_anomaly = get_mean_anomaly(now, body_elements[i]);
+                    const double eccentric_anomaly = tables[i] ? tables[i]->get(mean_anomaly, refine)
+                            : kepler::ecc_anomaly(body_elements[i].eccentricity, mean_anomaly);
+                    const PositionVelocity2D pv = get_heliocentric_position_velocity_from_eccentric_anomaly(
+                            eccentric_anomaly, body_elements[i]);
+                    p[i] = pv.p;
+                    v[i] = pv.v;
+                }
+            });
+        } else {
+            jobs::JobPool::get_singleton().parallel_for(count, propagation_grain_size, [=](int begin, int end) {
+                // Every body is propagated to the same time, the epochs in the elements tell them apart
+                const int block_size = 256;
+                double times[block_size];
+                for (int i = 0; i < block_size; i++) {
+                    times[i] = now;
+                }
+                for (int start = begin; start < end; start += block_size) {
+                    const int n = end - start < block_size ? end - start : block_size;
+                    get_heliocentric_position_velocity_from_time_batch(n, times, body_elements + start, p + start,
+                                                                       v + start);
+                }
+            });
+        }
+
+        // Bodies off rails take their integrated state instead
+        for (const int i : free_bodies) {
+            p[i] = Vector2(states[i].x, states[i].y);
+            v[i] = Vector2(states[i].vx, states[i].vy);
+        }
+
+        // Positions so far are relative to each body's focus, moons still have to be carried along by their planets
+        update_hierarchy();
+        if (hierarchy.is_nested()) hierarchy.accumulate(p, v, nullptr);
+        update_soi_index(p);
+    }
+
+    void OrbitSystem::advance(const double delta, const std::function<void(const OrbitEvent &)> &on_event) {
+        const double end = time + delta;
+        if (events_dirty) {
+            schedule_events();
+        } else if (!event_bodies.empty()) {
+            reschedule_body_events(time);
+        }
+        schedule_collisions(end);
+
+        OrbitEvent event;
+        while (events.pop(end, event)) {
+            if (event.type == ORBIT_EVENT_PERIAPSIS) {
+                events.push({event.time + elements[event.body].orbital_period, ORBIT_EVENT_PERIAPSIS, event.body,
+                             -1});
+            }
+            touched[event.body] = 1;
+            if (event.other >= 0) touched[event.other] = 1;
+
+            on_event(event);
+
+            // The handler changed the bodies, pick the schedule up again after the time of this event
+            if (events_dirty) {
+                time = event.time;
+                schedule_events();
+                schedule_collisions(end);
+            } else if (!event_bodies.empty()) {
+                reschedule_body_events(event.time);
+            }
+        }
+        time = end;
+
+        // Bodies to propagate, with the ancestors of every one of them so their foci are up to date as well.
+        // Bodies with a sphere of influence always move so the spheres stay where the bodies are, and bodies off
+        // rails are integrated every step.
+        const int count = static_cast<int>(elements.size());
+        for (int i = 0; i < count; i++) {
+            if (!visible[i] && !touched[i] && body_gravitational_parameters[i] <= 0.0 && !off_rails[i]) continue;
+            touched[i] = 1;
+            for (int parent = parents[i]; parent >= 0 && !touched[parent]; parent = parents[parent]) {
+                touched[parent] = 1;
+            }
+        }
+        active.clear();
+        for (int i = 0; i < count; i++) {
+            if (touched[i]) active.push_back(i);
+        }
+        propagate_bodies(active, touched.data());
+        touched.assign(count, 0);
+    }
+
+    void OrbitSystem::reset_events() {
+        events_dirty = true;
+    }
+
+    int OrbitSystem::add_body(const float eccentricity, const float semi_major_axis, const float argument_of_periapsis,
+                              const double epoch, const double mean_anomaly_at_epoch) {
+        if (!is_valid_orbit(eccentricity, semi_major_axis)) return -1;
+        elements.push_back(get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis,
+                                              standard_gravitational_parameter, epoch, mean_anomaly_at_epoch));
+        radii.push_back(0.0);
+        visible.push_back(1);
+        parents.push_back(-1);
+        body_gravitational_parameters.push_back(0.0);
+        off_rails.push_back(0);
+        perturbed.push_back(0);
+        thrusts.push_back(Vector2());
+        states.push_back(StateVector2D{0.0, 0.0, 0.0, 0.0});
+        hierarchy_dirty = true;
+        soi_index_dirty = true;
+        free_bodies_dirty = true;
+        body_tables_dirty = true;
+        overlap_index_dirty = true;
+        events_dirty = true;
+        return static_cast<int>(elements.size()) - 1;
+    }
+
+    bool OrbitSystem::set_body(const int index, const float eccentricity, const float semi_major_axis,
+                               const float argument_of_periapsis, const double epoch,
+                               const double mean_anomaly_at_epoch) {
+        if (!is_valid_orbit(eccentricity, semi_major_axis)) return false;
+        elements[index] = get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis,
+                                             get_primary_gravitational_parameter(index), epoch,
+                                             mean_anomaly_at_epoch);
+        // New elements put a body back on rails
+        off_rails[index] = 0;
+        perturbed[index] = 0;
+        thrusts[index] = Vector2();
+        free_bodies_dirty = true;
+        body_tables_dirty = true;
+        soi_index_dirty = true;
+        overlap_index_dirty = true;
+        invalidate_events(index);
+        return true;
+    }
+
+    void OrbitSystem::remove_body(const int index) {
+        elements.erase(elements.begin() + index);
+        radii.erase(radii.begin() + index);
+        visible.erase(visible.begin() + index);
+        off_rails.erase(off_rails.begin() + index);
+        perturbed.erase(perturbed.begin() + index);
+        thrusts.erase(thrusts.begin() + index);
+        states.erase(states.begin() + index);
+        if (index < static_cast<int>(touched.size())) touched.erase(touched.begin() + index);
+
+        // Satellites of the removed body move up to orbit its parent, and indices past it shift down by one
+        const int parent = parents[index];
+        parents.erase(parents.begin() + index);
+        body_gravitational_parameters.erase(body_gravitational_parameters.begin() + index);
+        for (int i = 0; i < static_cast<int>(parents.size()); i++) {
+            if (parents[i] == index) {
+                parents[i] = parent > index ? parent - 1 : parent;
+                rebuild_elements(i);
+            } else if (parents[i] > index) {
+                parents[i]--;
+            }
+        }
+        hierarchy_dirty = true;
+        soi_index_dirty = true;
+        free_bodies_dirty = true;
+        body_tables_dirty = true;
+        overlap_index_dirty = true;
+        events_dirty = true;
+    }
+
+    void OrbitSystem::clear_bodies() {
+        elements.clear();
+        radii.clear();
+        visible.clear();
+        off_rails.clear();
+        perturbed.clear();
+        thrusts.clear();
+        states.clear();
+        touched.clear();
+        parents.clear();
+        body_gravitational_parameters.clear();
+        hierarchy_dirty = true;
+        soi_index_dirty = true;
+        free_bodies_dirty = true;
+        body_tables_dirty = true;
+        overlap_index_dirty = true;
+        events_dirty = true;
+    }
+
+    int OrbitSystem::get_body_count() const {
+        return static_cast<int>(elements.size());
+    }
+
+    void OrbitSystem::set_body_radius(const int index, const float radius) {
+        radii[index] = radius > 0.0 ? radius : 0.0;
+        overlap_index_dirty = true;
+        invalidate_events(index);
+    }
+
+    float OrbitSystem::get_body_radius(const int index) const {
+        return radii[index];
+    }
+
+    void OrbitSystem::set_body_visible(const int index, const bool value) {
+        visible[index] = value;
+    }
+
+    bool OrbitSystem::is_body_visible(const int index) const {
+        return visible[index];
+    }
+
+    int OrbitSystem::get_pending_event_count() const {
+        return events.get_pending_count();
+    }
+
+    bool OrbitSystem::set_body_parent(const int index, const int parent) {
+        // A body cannot orbit itself or one of its own satellites
+        for (int ancestor = parent; ancestor >= 0; ancestor = parents[ancestor]) {
+            if (ancestor == index) return false;
+        }
+        parents[index] = parent;
+        rebuild_elements(index);
+        hierarchy_dirty = true;
+        soi_index_dirty = true;
+        overlap_index_dirty = true;
+        invalidate_events(index);
+        return true;
+    }
+
+    int OrbitSystem::get_body_parent(const int index) const {
+        return parents[index];
+    }
+
+    void OrbitSystem::set_body_standard_gravitational_parameter(const int index, const float value) {
+        body_gravitational_parameters[index] = value;
+        for (int i = 0; i < static_cast<int>(parents.size()); i++) {
+            if (parents[i] != index) continue;
+            rebuild_elements(i);
+            invalidate_events(i);
+        }
+        soi_index_dirty = true;
+    }
+
+    float OrbitSystem::get_body_standard_gravitational_parameter(const int index) const {
+        return body_gravitational_parameters[index];
+    }
+
+    void OrbitSystem::set_body_thrust(const int index, const Vector2 acceleration) {
+        // Bring every integrated state up to now under the thrust it had so far
+        integrate_free_bodies();
+        thrusts[index] = acceleration;
+        if (acceleration == Vector2()) {
+            // A body that cannot go back on rails yet coasts in the integrator and is retried after every step
+            if (off_rails[index] && !perturbed[index] && return_to_rails(index)) free_bodies_dirty = true;
+            return;
+        }
+        leave_rails(index);
+    }
+
+    Vector2 OrbitSystem::get_body_thrust(const int index) const {
+        return thrusts[index];
+    }
+
+    bool OrbitSystem::is_body_off_rails(const int index) const {
+        return off_rails[index];
+    }
+
+    void OrbitSystem::set_body_state(const int index, const Vector2 position, const Vector2 velocity) {
+        integrate_free_bodies();
+        leave_rails(index);
+        states[index] = StateVector2D{position.x, position.y, velocity.x, velocity.y};
+        // Bound orbits go straight back on rails, anything else coasts on its state
+        if (thrusts[index] == Vector2() && !perturbed[index] && return_to_rails(index)) free_bodies_dirty = true;
+    }
+
+    void OrbitSystem::set_body_perturbed(const int index, const bool value) {
+        integrate_free_bodies();
+        perturbed[index] = value;
+        if (value) {
+            leave_rails(index);
+        } else if (off_rails[index] && thrusts[index] == Vector2() && return_to_rails(index)) {
+            free_bodies_dirty = true;
+        }
+    }
+
+    bool OrbitSystem::is_body_perturbed(const int index) const {
+        return perturbed[index];
+    }
+
+    bool OrbitSystem::is_propagated() const {
+        return positions.size() == elements.size();
+    }
+
+    Vector2 OrbitSystem::get_focus(const int index) const {
+        return parents[index] < 0 ? Vector2() : positions[parents[index]];
+    }
+
+    int OrbitSystem::find_soi(const Vector2 point) {
+        // Spheres as of the last propagation, -1 is the primary at the origin
+        if (!is_propagated()) return -1;
+        if (soi_index_dirty) update_soi_index(positions.data());
+        return soi_index.find(point);
+    }
+
+    void OrbitSystem::find_soi_batch(const int count, const Vector2 *points, int *found) {
+        if (!is_propagated()) {
+            std::fill(found, found + count, -1);
+            return;
+        }
+        if (soi_index_dirty) update_soi_index(positions.data());
+        soi_index.find_batch(count, points, found);
+    }
+
+    void OrbitSystem::update_soi_transitions(std::vector<int> &transitions) {
+        transitions.clear();
+        if (!is_propagated()) return;
+        if (soi_index_dirty) update_soi_index(positions.data());
+
+        // Only massless bodies change hands, the bodies with spheres of their own stay on their orbits
+        const int count = static_cast<int>(elements.size());
+        std::vector<int> bodies;
+        std::vector<Vector2> points;
+        for (int i = 0; i < count; i++) {
+            if (body_gravitational_parameters[i] > 0.0) continue;
+            bodies.push_back(i);
+            points.push_back(positions[i]);
+        }
+        std::vector<int> found(bodies.size());
+        soi_index.find_batch(static_cast<int>(bodies.size()), points.data(), found.data());
+
+        // Re-fit every body that crossed into another sphere to its state relative to the new primary
+        for (int k = 0; k < static_cast<int>(bodies.size()); k++) {
+            const int i = bodies[k];
+            const int parent = found[k];
+            if (parent == parents[i]) continue;
+            bool cycle = false;
+            for (int ancestor = parent; ancestor >= 0; ancestor = parents[ancestor]) {
+                cycle = cycle || ancestor == i;
+            }
+            if (cycle) continue;
+
+            const Vector2 position = parent < 0 ? positions[i] : positions[i] - positions[parent];
+            const Vector2 velocity = parent < 0 ? velocities[i] : velocities[i] - velocities[parent];
+            const float primary = parent < 0 ? standard_gravitational_parameter : body_gravitational_parameters[parent];
+            if (off_rails[i]) {
+                // Integrated bodies keep their state, only measured from the new primary
+                states[i] = StateVector2D{position.x, position.y, velocity.x, velocity.y};
+            } else if (!get_orbit_elements_from_state(position, velocity, primary, time, elements[i])) {
+                continue;
+            }
+            parents[i] = parent;
+            transitions.push_back(i);
+            invalidate_events(i);
+        }
+
+        if (!transitions.empty()) {
+            hierarchy_dirty = true;
+            body_tables_dirty = true;
+            overlap_index_dirty = true;
+        }
+    }
+
+    void OrbitSystem::find_intercepting_pairs(std::vector<std::pair<int, int>> &pairs) {
+        update_overlap_index();
+        overlap_index.find_intercepting_pairs(pairs);
+        // Orbits only cross in a meaningful way when they share a focus
+        pairs.erase(std::remove_if(pairs.begin(), pairs.end(), [this](const std::pair<int, int> &pair) {
+            return parents[pair.first] != parents[pair.second];
+        }), pairs.end());
+    }
+
+    int OrbitSystem::find_intercept_points(const int index1, const int index2, Vector2 *points) const {
+        return orbits::find_intercept_points(elements[index1], Vector2(), elements[index2], Vector2(), points);
+    }
+
+    void OrbitSystem::find_next_overlap_times(const int pair_count, const int *pairs, const float *body_radii,
+                                              const double duration, double *times) const {
+        // Times are on the system clock
+        std::vector<Vector2> foci(elements.size());
+        find_next_overlap_time_batch(pair_count, pairs, elements.data(), foci.data(), body_radii, time,
+                                     time + duration, duration * overlap_tolerance_fraction, times);
+    }
+
+    bool OrbitSystem::get_transfer_velocities(const int focus, const Vector2 from, const Vector2 to,
+                                              const double time_of_flight, Vector2 &departure_velocity,
+                                              Vector2 &arrival_velocity) const {
+        const float mu = focus < 0 ? standard_gravitational_parameter : body_gravitational_parameters[focus];
+        return solve_lambert(from, to, time_of_flight, mu, departure_velocity, arrival_velocity);
+    }
+
+    void OrbitSystem::get_porkchop_plot(const int departure_body, const int arrival_body,
+                                        const double departure_start, const double departure_step,
+                                        const int departure_count, const double arrival_start,
+                                        const double arrival_step, const int arrival_count,
+                                        const int coarse_stride, float *delta_v) const {
+        get_porkchop_grid_refined(elements[departure_body], elements[arrival_body], departure_start, departure_step,
+                                  departure_count, arrival_start, arrival_step, arrival_count, coarse_stride,
+                                  delta_v);
+    }
+
+    bool OrbitSystem::get_nearest_points(const int index, const int count, const Vector2 *points,
+                                         NearestPoint *nearest) const {
+        if (!is_propagated()) return false;
+        get_nearest_points_batch(elements[index], get_focus(index), count, points, time, nearest);
+        return true;
+    }
+
+    int OrbitSystem::find_nearest_body(const Vector2 point, const float max_distance) const {
+        // Bodies off rails have no orbit to snap to and are skipped
+        const int count = static_cast<int>(elements.size());
+        if (!is_propagated()) return -1;
+        std::vector<Vector2> foci(count);
+        std::vector<char> on_rails(count);
+        for (int i = 0; i < count; i++) {
+            foci[i] = get_focus(i);
+            on_rails[i] = !off_rails[i];
+        }
+        NearestPoint nearest;
+        return find_nearest_orbit(count, elements.data(), foci.data(), on_rails.data(), point, max_distance, time,
+                                  nearest);
+    }
+
+    int OrbitSystem::get_kepler_table_count() const {
+        return kepler_tables.get_table_count();
+    }
+
+    std::size_t OrbitSystem::get_kepler_table_memory_usage() const {
+        return kepler_tables.get_memory_usage();
+    }
+
+    const std::vector<Vector2> &OrbitSystem::get_positions() const {
+        return positions;
+    }
+
+    const std::vector<Vector2> &OrbitSystem::get_velocities() const {
+        return velocities;
+    }
+
+    void OrbitSystem::set_standard_gravitational_parameter(const float value) {
+        standard_gravitational_parameter = value;
+        for (int i = 0; i < static_cast<int>(elements.size()); i++) {
+            if (parents[i] < 0) rebuild_elements(i);
+        }
+        soi_index_dirty = true;
+        events_dirty = true;
+    }
+
+    float OrbitSystem::get_standard_gravitational_parameter() const {
+        return standard_gravitational_parameter;
+    }
+
+    void OrbitSystem::set_time(const double value) {
+        time = value;
+        events_dirty = true;
+    }
+
+    double OrbitSystem::get_time() const {
+        return time;
+    }
+
+    void OrbitSystem::set_kepler_table_enabled(const bool value) {
+        kepler_table_enabled = value;
+        if (!kepler_table_enabled) {
+            kepler_tables.clear();
+        }
+        body_tables_dirty = true;
+    }
+
+    bool OrbitSystem::get_kepler_table_enabled() const {
+        return kepler_table_enabled;
+    }
+
+    void OrbitSystem::set_kepler_table_refine(const bool value) {
+        kepler_table_refine = value;
+    }
+
+    bool OrbitSystem::get_kepler_table_refine() const {
+        return kepler_table_refine;
+    }
+
+    void OrbitSystem::set_kepler_table_tolerance(const float value) {
+        kepler_tables.set_tolerance(value);
+        body_tables_dirty = true;
+    }
+
+    float OrbitSystem::get_kepler_table_tolerance() const {
+        return kepler_tables.get_tolerance();
+    }
+
+    void OrbitSystem::set_kepler_table_memory_budget(const int value) {
+        kepler_tables.set_memory_budget(value > 0 ? value : 0);
+        kepler_tables.clear();
+        body_tables_dirty = true;
+    }
+
+    int OrbitSystem::get_kepler_table_memory_budget() const {
+        return static_cast<int>(kepler_tables.get_memory_budget());
+    }
+
+    void OrbitSystem::set_soi_radius(const float value) {
+        soi_radius = value > 0.0 ? value : 0.0;
+        events_dirty = true;
+    }
+
+    float OrbitSystem::get_soi_radius() const {
+        return soi_radius;
+    }
+
+    void OrbitSystem::set_event_horizon(const float value) {
+        event_horizon = value;
+        events_dirty = true;
+    }
+
+    float OrbitSystem::get_event_horizon() const {
+        return event_horizon;
+    }
+
+    void OrbitSystem::set_integrator_step_fraction(const float value) {
+        integrator_step_fraction = value;
+    }
+
+    float OrbitSystem::get_integrator_step_fraction() const {
+        return integrator_step_fraction;
+    }
+
+    void OrbitSystem::set_nbody_opening_angle(const float value) {
+        nbody_opening_angle = value;
+    }
+
+    float OrbitSystem::get_nbody_opening_angle() const {
+        return nbody_opening_angle;
+    }
+
+    void OrbitSystem::set_nbody_softening(const float value) {
+        nbody_softening = value;
+    }
+
+    float OrbitSystem::get_nbody_softening() const {
+        return nbody_softening;
+    }
+
+}
@@ -0,0 +1,364 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <Godot.hpp>
+
+#include "kepler_table.hpp"
+#include "orbit_events.hpp"
+#include "orbit_hierarchy.hpp"
+#include "orbit_index.hpp"
+#include "orbit_integrator.hpp"
+#include "orbit_lambert.hpp"
+#include "orbit_nbody.hpp"
+#include "orbit_nearest.hpp"
+#include "orbit_soi.hpp"
+#include "orbit_universal.hpp"
+#include "orbits.hpp"
+
+namespace orbits {
+
+    /**
+    Many bodies orbiting a primary at the origin, or each other, propagated together across the job pool. This is
+    the state and logic behind OrbitSystem2D, which only converts its arguments and reports errors.
+
+    Bodies are stored as parallel arrays indexed by body id. Every derived structure, the parent hierarchy, the
+    Kepler tables, the overlap and sphere of influence indices, the list of bodies off rails and the event schedule,
+    is marked dirty by the changes that affect it and rebuilt when it is next needed, so a burst of edits between
+    two propagations costs one rebuild.
+
+    Positions and velocities are those of the last propagation, absolute, with every moon carried along by its
+    planet. Methods taking a body index expect a valid one.
+    */
+    class OrbitSystem {
+    public:
+        OrbitSystem();
+
+        /**
+        @return whether a body can be put on these elements, a positive semi-major axis and an eccentricity in
+                [0, 1). Anything else has no period for the propagation and the events to use.
+        */
+        static bool is_valid_orbit(const float eccentricity, const float semi_major_axis);
+
+        /**
+        Propagates every body to the current time.
+        */
+        void propagate();
+
+        /**
+        Moves the clock forward by delta, handing every event due on the way to on_event in time order. on_event may
+        change the bodies, their schedule is then picked up again after the time of the event. Only visible bodies,
+        bodies with a sphere of influence, bodies off rails and bodies that had an event are propagated.
+        */
+        void advance(const double delta, const std::function<void(const OrbitEvent &)> &on_event);
+
+        /**
+        Drops the event schedule, it is built again from the current time by the next advance.
+        */
+        void reset_events();
+
+        /**
+        @return index of the new body, -1 if the elements are not valid
+        */
+        int add_body(const float eccentricity, const float semi_major_axis, const float argument_of_periapsis,
+                     const double epoch, const double mean_anomaly_at_epoch);
+
+        /**
+        Puts a body on new elements around its current primary, and back on rails.
+
+        @return false if the elements are not valid
+        */
+        bool set_body(const int index, const float eccentricity, const float semi_major_axis,
+                      const float argument_of_periapsis, const double epoch, const double mean_anomaly_at_epoch);
+
+        /**
+        Satellites of the removed body move up to orbit its parent, and indices past it shift down by one.
+        */
+        void remove_body(const int index);
+
+        void clear_bodies();
+
+        int get_body_count() const;
+
+        void set_body_radius(const int index, const float radius);
+
+        float get_body_radius(const int index) const;
+
+        void set_body_visible(const int index, const bool visible);
+
+        bool is_body_visible(const int index) const;
+
+        int get_pending_event_count() const;
+
+        /**
+        @param parent body to orbit, -1 for the origin
+        @return false if index would end up orbiting itself or one of its own satellites
+        */
+        bool set_body_parent(const int index, const int parent);
+
+        int get_body_parent(const int index) const;
+
+        void set_body_standard_gravitational_parameter(const int index, const float value);
+
+        float get_body_standard_gravitational_parameter(const int index) const;
+
+        /**
+        A body under thrust leaves its elements and is integrated around its primary. Once the thrust stops it goes
+        back on rails as soon as it is on an orbit the elements can describe.
+        */
+        void set_body_thrust(const int index, const godot::Vector2 acceleration);
+
+        godot::Vector2 get_body_thrust(const int index) const;
+
+        bool is_body_off_rails(const int index) const;
+
+        /**
+        Places a body at a state relative to its primary. Bound counter-clockwise orbits go straight back on rails,
+        anything else coasts along its conic off rails.
+        */
+        void set_body_state(const int index, const godot::Vector2 position, const godot::Vector2 velocity);
+
+        void set_body_perturbed(const int index, const bool perturbed);
+
+        bool is_body_perturbed(const int index) const;
+
+        /**
+        @return false until the bodies added or removed since the last propagation have been propagated, the
+                queries against the last propagation answer as if there were no bodies until then
+        */
+        bool is_propagated() const;
+
+        /**
+        @return focus of the orbit of a body as of the last propagation, the origin for bodies orbiting it
+        */
+        godot::Vector2 get_focus(const int index) const;
+
+        /**
+        @return the body whose sphere of influence point is in as of the last propagation, -1 for the primary at
+                the origin
+        */
+        int find_soi(const godot::Vector2 point);
+
+        void find_soi_batch(const int count, const godot::Vector2 *points, int *found);
+
+        /**
+        Hands every massless body that entered or left a sphere of influence over to the body whose sphere it is in
+        now, refitting its orbit to its state relative to the new primary. Bodies that would not be on a bound
+        counter-clockwise orbit around it stay with their old primary.
+
+        @param transitions output, the bodies that changed primary
+        */
+        void update_soi_transitions(std::vector<int> &transitions);
+
+        /**
+        @param pairs output, pairs of bodies around the same focus whose orbits cross
+        */
+        void find_intercepting_pairs(std::vector<std::pair<int, int>> &pairs);
+
+        /**
+        @param points output, up to 4 crossings of the orbits of two bodies around the same focus
+        @return number of points
+        */
+        int find_intercept_points(const int index1, const int index2, godot::Vector2 *points) const;
+
+        /**
+        First time every pair of bodies around the same focus comes within the sum of their radii, searched from
+        the current time over duration.
+
+        @param pairs flattened [i0, j0, i1, j1, ...]
+        @param radii radius of every body
+        @param times output, infinity for pairs that do not touch in time
+        */
+        void find_next_overlap_times(const int pair_count, const int *pairs, const float *radii,
+                                     const double duration, double *times) const;
+
+        /**
+        @param focus body the positions and velocities are relative to, -1 for the primary at the origin
+        @return false if there is no transfer
+        */
+        bool get_transfer_velocities(const int focus, const godot::Vector2 from, const godot::Vector2 to,
+                                     const double time_of_flight, godot::Vector2 &departure_velocity,
+                                     godot::Vector2 &arrival_velocity) const;
+
+        /**
+        get_porkchop_grid_refined between the orbits of two bodies around the same focus.
+        */
+        void get_porkchop_plot(const int departure_body, const int arrival_body, const double departure_start,
+                               const double departure_step, const int departure_count, const double arrival_start,
+                               const double arrival_step, const int arrival_count, const int coarse_stride,
+                               float *delta_v) const;
+
+        /**
+        Snaps points onto the orbit of a body on rails, around its focus as of the last propagation.
+
+        @return false if the bodies have not been propagated yet
+        */
+        bool get_nearest_points(const int index, const int count, const godot::Vector2 *points,
+                                NearestPoint *nearest) const;
+
+        /**
+        @return body on rails whose orbit passes closest to point, -1 if none is within max_distance
+        */
+        int find_nearest_body(const godot::Vector2 point, const float max_distance) const;
+
+        int get_kepler_table_count() const;
+
+        std::size_t get_kepler_table_memory_usage() const;
+
+        const std::vector<godot::Vector2> &get_positions() const;
+
+        const std::vector<godot::Vector2> &get_velocities() const;
+
+        void set_standard_gravitational_parameter(const float value);
+
+        float get_standard_gravitational_parameter() const;
+
+        void set_time(const double value);
+
+        double get_time() const;
+
+        void set_kepler_table_enabled(const bool value);
+
+        bool get_kepler_table_enabled() const;
+
+        void set_kepler_table_refine(const bool value);
+
+        bool get_kepler_table_refine() const;
+
+        void set_kepler_table_tolerance(const float value);
+
+        float get_kepler_table_tolerance() const;
+
+        void set_kepler_table_memory_budget(const int value);
+
+        int get_kepler_table_memory_budget() const;
+
+        /**
+        @param value radius of the sphere of influence of the primary at the origin, 0 for no exit events
+        */
+        void set_soi_radius(const float value);
+
+        float get_soi_radius() const;
+
+        /**
+        @param value length of the windows contacts are scheduled in, 0 for the whole of every advance
+        */
+        void set_event_horizon(const float value);
+
+        float get_event_horizon() const;
+
+        /**
+        @param value longest integration substep as a fraction of the free fall time, positive
+        */
+        void set_integrator_step_fraction(const float value);
+
+        float get_integrator_step_fraction() const;
+
+        /**
+        @param value largest size over distance of a tree node summed as a point mass, 0 sums directly
+        */
+        void set_nbody_opening_angle(const float value);
+
+        float get_nbody_opening_angle() const;
+
+        void set_nbody_softening(const float value);
+
+        float get_nbody_softening() const;
+
+    private:
+        void update_overlap_index();
+
+        void update_hierarchy();
+
+        void update_soi_index(const godot::Vector2 *body_positions);
+
+        float get_primary_gravitational_parameter(const int index) const;
+
+        void rebuild_elements(const int index);
+
+        void schedule_events();
+
+        void schedule_collisions(const double end);
+
+        void invalidate_events(const int index);
+
+        void reschedule_body_events(const double from);
+
+        void push_body_events(const int index, const double from);
+
+        void update_collision_pairs();
+
+        void push_collisions(const std::vector<int> &pairs, const double start, const double end);
+
+        void propagate_bodies(const std::vector<int> &bodies, const char *mask);
+
+        void integrate_free_bodies();
+
+        void leave_rails(const int index);
+
+        bool return_to_rails(const int index);
+
+        void add_perturbations(std::vector<godot::Vector2> &accelerations);
+
+        // Settings
+        float standard_gravitational_parameter;
+        double time;
+        bool kepler_table_enabled;
+        bool kepler_table_refine;
+        float soi_radius;
+        float event_horizon;
+        float integrator_step_fraction;
+        float nbody_opening_angle;
+        float nbody_softening;
+
+        // Bodies, each orbit carries its own epoch
+        std::vector<OrbitElements> elements;
+        std::vector<float> radii;
+        std::vector<char> visible;
+        std::vector<int> parents;                       // body each body orbits, -1 for the origin
+        std::vector<float> body_gravitational_parameters;  // of each body, for the bodies orbiting it
+
+        // Bodies sorted by depth in the parent hierarchy
+        OrbitHierarchy hierarchy;
+        bool hierarchy_dirty;
+
+        // Table driven Kepler mode, one table per distinct eccentricity
+        kepler::EccAnomalyTableCache kepler_tables;
+        std::vector<const kepler::EccAnomalyTable *> body_tables;
+        bool body_tables_dirty;
+
+        // Broad phase for intercept queries
+        OrbitOverlapIndex overlap_index;
+        bool overlap_index_dirty;
+
+        // Spheres of influence of the bodies with a standard gravitational parameter, moved along every propagation
+        SphereOfInfluenceIndex soi_index;
+        std::vector<int> soi_bodies;
+        bool soi_index_dirty;
+
+        // Bodies off rails, integrated from a state relative to their focus instead of following their elements
+        std::vector<char> off_rails;
+        std::vector<godot::Vector2> thrusts;
+        std::vector<StateVector2D> states;
+        std::vector<char> perturbed;
+        std::vector<int> free_bodies;
+        bool free_bodies_dirty;
+        double integrated_time;  // time the states are at
+        BarnesHutTree nbody_tree;
+
+        // Event schedule
+        OrbitEventQueue events;
+        std::vector<int> collision_pairs;  // flattened [i0, j0, i1, j1, ...]
+        double collision_search_end;       // contacts are scheduled up to this time
+        bool events_dirty;
+        std::vector<int> event_bodies;     // bodies whose events changed since they were scheduled
+        std::vector<char> touched;
+        std::vector<int> active;
+
+        // Results of the last propagation
+        std::vector<godot::Vector2> positions;
+        std::vector<godot::Vector2> velocities;
+    };
+
+}
@@ -0,0 +1,282 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "job_pool.hpp"
+#include "orbit_universal.hpp"
+#include "stats.hpp"
+
+namespace orbits {
+
+    // Bodies per task handed to the job pool, a few Laguerre-Conway iterations each
+    static const int propagation_grain_size = 256;
+
+    namespace {
+        const int lanes = 8;
+
+        // Laguerre-Conway of order 5 takes 3 to 7 iterations on any conic from the starting values below
+        const double laguerre_order = 5.0;
+        const int max_iterations = 32;
+        const double tolerance = 1e-13;  // on the change of chi relative to chi
+
+        // F cancels down from its four terms, which far out on a hyperbola are much larger than F and leave it
+        // noisier than the tolerance, so chi is also taken as converged once the steps are down to that noise
+        const double roundoff = 64.0 * DBL_EPSILON;
+
+        // Quarterings of z before the series, enough for |z| up to 2^126 where cosh overflows anyway
+        const int max_quarterings = 64;
+
+        /**
+        Number of times z has to be divided by 4 to bring it below 1/4, read off its exponent.
+        */
+        inline int get_quarterings(const double z) {
+            uint64_t bits;
+            std::memcpy(&bits, &z, sizeof(bits));
+            // |z| < 2^(exponent + 1), so k quarterings leave it below 2^(exponent + 1 - 2 k)
+            const int exponent = static_cast<int>((bits >> 52) & 0x7ff) - 1023;
+            const int k = (exponent + 4) / 2;
+            return k < 0 ? 0 : (k > max_quarterings ? max_quarterings : k);
+        }
+
+        /**
+        @return 4^-k, built from its exponent bits
+        */
+        inline double get_inverse_power_of_four(const int k) {
+            const uint64_t bits = static_cast<uint64_t>(1023 - 2 * k) << 52;
+            double power;
+            std::memcpy(&power, &bits, sizeof(power));
+            return power;
+        }
+
+        /**
+        c2 and c3 from their series, for |x| below 1/4 where 8 terms reach double precision, and c0 and c1 from the
+        identities c0 = 1 - x c2 and c1 = 1 - x c3.
+        */
+        inline void get_stumpff_series(const double x, double &c0, double &c1, double &c2, double &c3) {
+            c2 = 1.0 / 2.0 - x * (1.0 / 24.0 - x * (1.0 / 720.0 - x * (1.0 / 40320.0 - x * (1.0 / 3628800.0 - x * (
+                    1.0 / 479001600.0 - x * (1.0 / 87178291200.0 - x / 20922789888000.0))))));
+            c3 = 1.0 / 6.0 - x * (1.0 / 120.0 - x * (1.0 / 5040.0 - x * (1.0 / 362880.0 - x * (1.0 / 39916800.0 - x * (
+                    1.0 / 6227020800.0 - x * (1.0 / 1307674368000.0 - x / 355687428096000.0))))));
+            c0 = 1.0 - x * c2;
+            c1 = 1.0 - x * c3;
+        }
+
+        /**
+        One step of the quadruple angle formulas, from the functions at z to the functions at 4 z.
+        */
+        inline void quadruple_stumpff(double &c0, double &c1, double &c2, double &c3) {
+            c3 = 0.25 * (c2 + c0 * c3);
+            c2 = 0.5 * c1 * c1;
+            c1 = c0 * c1;
+            c0 = 2.0 * c0 * c0 - 1.0;
+        }
+
+        /**
+        get_stumpff for a group of lanes, quadrupling every lane as often as the lane needing the most and keeping
+        the steps of the others masked out, so the loops stay free of data dependent branches.
+        */
+        inline void get_stumpff_lanes(const double *z, double *c0, double *c1, double *c2, double *c3) {
+            int quarterings[lanes];
+            int max_k = 0;
+            for (int i = 0; i < lanes; i++) {
+                quarterings[i] = get_quarterings(z[i]);
+                get_stumpff_series(z[i] * get_inverse_power_of_four(quarterings[i]), c0[i], c1[i], c2[i], c3[i]);
+                max_k = quarterings[i] > max_k ? quarterings[i] : max_k;
+            }
+            for (int k = 0; k < max_k; k++) {
+                for (int i = 0; i < lanes; i++) {
+                    double q0 = c0[i], q1 = c1[i], q2 = c2[i], q3 = c3[i];
+                    quadruple_stumpff(q0, q1, q2, q3);
+                    const bool step = k < quarterings[i];
+                    c0[i] = step ? q0 : c0[i];
+                    c1[i] = step ? q1 : c1[i];
+                    c2[i] = step ? q2 : c2[i];
+                    c3[i] = step ? q3 : c3[i];
+                }
+            }
+        }
+
+        /**
+        Advances a group of lanes by duration.
+
+        @param valid number of lanes holding real bodies, the rest is padding and is not written back
+        @param histogram iterations counted into it for the valid lanes, stats::kepler_histogram_size buckets
+        @param failures incremented for every valid lane that did not converge
+        */
+        void propagate_universal_lanes(StateVector2D *states, const double *standard_gravitational_parameters,
+                                       const double duration, const int valid, uint64_t *histogram,
+                                       uint64_t &failures) {
+            double r0[lanes], sigma0[lanes], alpha[lanes], sqrt_mu[lanes], dt[lanes], chi[lanes], delta[lanes];
+            double limit[lanes], lo[lanes], hi[lanes], previous[lanes];
+            double z[lanes], c0[lanes], c1[lanes], c2[lanes], c3[lanes];
+
+            for (int i = 0; i < lanes; i++) {
+                const StateVector2D &s = states[i];
+                // A primary without gravity, such as a body whose own parameter is not set yet, is stood in for
+                // by a unit one and the lane is written back as a straight line
+                const double given = standard_gravitational_parameters[i];
+                const double mu = given > 0.0 ? given : 1.0;
+                const double r = std::sqrt(s.x * s.x + s.y * s.y);
+                r0[i] = r > 0.0 ? r : 1.0;  // a body at the origin is skipped on write back
+                sqrt_mu[i] = std::sqrt(mu);
+                sigma0[i] = (s.x * s.vx + s.y * s.vy) / sqrt_mu[i];
+                alpha[i] = 2.0 / r0[i] - (s.vx * s.vx + s.vy * s.vy) / mu;
+
+                // Whole periods of an ellipse change nothing, dropping them keeps chi within one turn
+                const double period = alpha[i] > 0.0 ? 2.0 * M_PI / (sqrt_mu[i] * alpha[i] * std::sqrt(alpha[i])) : 0.0;
+                dt[i] = period > 0.0 ? duration - period * std::floor(duration / period + 0.5) : duration;
+
+                // Starting values, Vallado's for ellipses and hyperbolas and the one of a straight line, picked by
+                // select rather than by branch. Vallado's hyperbolic value is only asymptotically right and comes
+                // out nan or on the wrong side near parabolas, where the straight line is the better start anyway.
+                // Far from them it is the only good one, chi grows with the log of the time of flight there.
+                const double elliptic = sqrt_mu[i] * alpha[i] * dt[i];
+                const double a = 1.0 / alpha[i];
+                const double sign = dt[i] < 0.0 ? -1.0 : 1.0;
+                const double hyperbolic = sign * std::sqrt(-a) * std::log(
+                        -2.0 * mu * alpha[i] * dt[i]
+                        / (sigma0[i] * sqrt_mu[i] + sign * std::sqrt(-mu * a) * (1.0 - r0[i] * alpha[i])));
+                const double linear = sqrt_mu[i] * dt[i] / r0[i];
+                const bool use_hyperbolic = sign * hyperbolic > 0.0 && sign * hyperbolic < sign * linear;
+                chi[i] = alpha[i] > 0.0 ? elliptic : (use_hyperbolic ? hyperbolic : linear);
+
+                // F below is increasing in chi, its derivative is r, and F(0) = -sqrt(mu) dt puts the root on the
+                // side of 0 that dt is on. The other side of the bracket stays open until F is seen to change sign.
+                lo[i] = dt[i] < 0.0 ? -INFINITY : 0.0;
+                hi[i] = dt[i] < 0.0 ? 0.0 : INFINITY;
+                previous[i] = INFINITY;
+                delta[i] = INFINITY;
+                limit[i] = 0.0;
+            }
+
+            // Laguerre-Conway on F(chi) = sigma0 chi^2 c2 + (1 - alpha r0) chi^3 c3 + r0 chi - sqrt(mu) dt, every lane
+            // runs until the slowest lane of the group has converged. From a poor start on a fast, nearly radial
+            // hyperbola it can jump far past the root, where F grows exponentially and the steps back crawl, or
+            // overflows. Steps that leave the bracket of the root or do not halve from the last one are replaced
+            // by bisection, or by doubling chi while the bracket is still open on that side. A converged lane is
+            // left where it is, further steps there would only bisect on round-off.
+            int count = 0;
+            bool converged = false;
+            while (count < max_iterations && !converged) {
+                for (int i = 0; i < lanes; i++) {
+                    z[i] = alpha[i] * chi[i] * chi[i];
+                }
+                get_stumpff_lanes(z, c0, c1, c2, c3);
+                for (int i = 0; i < lanes; i++) {
+                    const bool done = std::fabs(delta[i]) <= limit[i];
+                    const double x = chi[i];
+                    const double k = 1.0 - alpha[i] * r0[i];
+                    const double quadratic = sigma0[i] * x * x * c2[i];
+                    const double cubic = k * x * x * x * c3[i];
+                    const double F = quadratic + cubic + r0[i] * x - sqrt_mu[i] * dt[i];
+                    const double dF = sigma0[i] * x * c1[i] + k * x * x * c2[i] + r0[i];
+                    const double ddF = sigma0[i] * c0[i] + k * x * c1[i];
+                    const double n = laguerre_order;
+                    const double root = std::sqrt(std::fabs((n - 1.0) * (n - 1.0) * dF * dF - n * (n - 1.0) * F * ddF));
+                    // F is nan once it overflows, which only happens far out on the side of x
+                    const bool below = F < 0.0 || (F != F && x < 0.0);
+                    const bool above = F > 0.0 || (F != F && x > 0.0);
+                    lo[i] = below ? x : lo[i];
+                    hi[i] = above ? x : hi[i];
+                    const double step = x - n * F / (dF + (dF < 0.0 ? -root : root));
+                    const double fallback = std::isinf(lo[i]) || std::isinf(hi[i]) ? 2.0 * x : 0.5 * (lo[i] + hi[i]);
+                    const double noise = roundoff * (std::fabs(quadratic) + std::fabs(cubic) + r0[i] * std::fabs(x)
+                            + sqrt_mu[i] * std::fabs(dt[i]));
+                    const double step_limit = std::max(tolerance * std::fabs(step), noise / std::fabs(dF));
+                    const double size = std::fabs(x - step);
+                    const bool accept = step >= lo[i] && step <= hi[i]
+                            && (size <= 0.5 * previous[i] || size <= step_limit);
+                    const double next = accept ? step : fallback;
+                    delta[i] = done ? delta[i] : x - next;
+                    limit[i] = done ? limit[i] : std::max(tolerance * std::fabs(next), noise / std::fabs(dF));
+                    previous[i] = std::fabs(delta[i]);
+                    chi[i] = done ? x : next;
+                }
+                count++;
+
+                converged = true;
+                for (int i = 0; i < lanes; i++) {
+                    converged &= std::fabs(delta[i]) <= limit[i];
+                }
+            }
+
+            // Lagrange coefficients at the solution
+            for (int i = 0; i < lanes; i++) {
+                z[i] = alpha[i] * chi[i] * chi[i];
+            }
+            get_stumpff_lanes(z, c0, c1, c2, c3);
+            for (int i = 0; i < valid; i++) {
+                StateVector2D &s = states[i];
+                const double x = chi[i];
+                const double r = sigma0[i] * x * c1[i] + (1.0 - alpha[i] * r0[i]) * x * x * c2[i] + r0[i];
+                const double f = 1.0 - x * x * c2[i] / r0[i];
+                const double g = dt[i] - x * x * x * c3[i] / sqrt_mu[i];
+                const double f_dot = -sqrt_mu[i] * x * c1[i] / (r * r0[i]);
+                const double g_dot = 1.0 - x * x * c2[i] / r;
+                const bool moved = s.x != 0.0 || s.y != 0.0;
+                const StateVector2D next = {
+                        f * s.x + g * s.vx,
+                        f * s.y + g * s.vy,
+                        f_dot * s.x + g_dot * s.vx,
+                        f_dot * s.y + g_dot * s.vy
+                };
+                const StateVector2D straight = {s.x + duration * s.vx, s.y + duration * s.vy, s.vx, s.vy};
+                s = standard_gravitational_parameters[i] > 0.0 ? (moved ? next : s) : straight;
+                failures += !(std::fabs(delta[i]) <= limit[i]);
+            }
+            histogram[count < stats::kepler_histogram_size ? count : stats::kepler_histogram_size - 1] += valid;
+        }
+
+        /**
+        propagate_universal_lanes over a range of bodies, padding the last group by repeating its last body.
+        */
+        void propagate_universal_range(const int count, StateVector2D *states,
+                                       const double *standard_gravitational_parameters, const double duration) {
+            uint64_t histogram[stats::kepler_histogram_size] = {};
+            uint64_t failures = 0;
+            int i = 0;
+            for (; i + lanes <= count; i += lanes) {
+                propagate_universal_lanes(states + i, standard_gravitational_parameters + i, duration, lanes,
+                                          histogram, failures);
+            }
+            if (i < count) {
+                StateVector2D padded[lanes];
+                double mu[lanes];
+                for (int j = 0; j < lanes; j++) {
+                    const int k = i + j < count ? i + j : count - 1;
+                    padded[j] = states[k];
+                    mu[j] = standard_gravitational_parameters[k];
+                }
+                propagate_universal_lanes(padded, mu, duration, count - i, histogram, failures);
+                for (int j = 0; i + j < count; j++) {
+                    states[i + j] = padded[j];
+                }
+            }
+            stats::add_kepler_solves(histogram, failures);
+        }
+    }
+
+    void get_stumpff(const double z, double &c0, double &c1, double &c2, double &c3) {
+        const int quarterings = get_quarterings(z);
+        get_stumpff_series(z * get_inverse_power_of_four(quarterings), c0, c1, c2, c3);
+        for (int k = 0; k < quarterings; k++) {
+            quadruple_stumpff(c0, c1, c2, c3);
+        }
+    }
+
+    void propagate_universal(StateVector2D &state, const double standard_gravitational_parameter,
+                             const double duration) {
+        propagate_universal_range(1, &state, &standard_gravitational_parameter, duration);
+    }
+
+    void propagate_universal_batch(const int count, StateVector2D *states,
+                                   const double *standard_gravitational_parameters, const double duration) {
+        jobs::JobPool::get_singleton().parallel_for(count, propagation_grain_size, [=](int begin, int end) {
+            propagate_universal_range(end - begin, states + begin, standard_gravitational_parameters + begin,
+                                      duration);
+        });
+    }
+
+}
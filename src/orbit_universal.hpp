@@ -0,0 +1,51 @@
+#pragma once
+
+#include "orbit_integrator.hpp"
+
+namespace orbits {
+
+    /**
+    Stumpff functions c0 = cos sqrt(z), c1 = sin sqrt(z) / sqrt(z), c2 = (1 - cos sqrt(z)) / z and
+    c3 = (sqrt(z) - sin sqrt(z)) / sqrt(z)^3, continued to cosh and sinh for negative z.
+
+    Evaluated without trig or hyperbolic functions and without a branch on the sign of z: z is divided by 4 until
+    it is small, the series are summed there and the quadruple angle formulas bring them back up. The same
+    arithmetic therefore serves ellipses, parabolas and hyperbolas, and stays accurate around z = 0 where the
+    closed forms cancel.
+    */
+    void get_stumpff(const double z, double &c0, double &c1, double &c2, double &c3);
+
+    /**
+    Advances a body coasting around a primary at the origin along its conic, whatever the conic is, by solving the
+    universal Kepler equation for the universal anomaly chi. See Vallado, Fundamentals of Astrodynamics and
+    Applications, algorithm 8, with the Laguerre-Conway iteration instead of Newton's. The iteration is kept inside
+    a bracket of the root and falls back to bisection when it stalls or overshoots, as it can on fast, nearly
+    radial hyperbolic passes.
+
+    Unlike the eccentric anomaly, chi stays well conditioned through e = 1, so escape trajectories, parabolic
+    passes and nearly parabolic ellipses all take the same few iterations.
+
+    @param state the body, advanced by duration on return. Left untouched at the origin.
+    @param standard_gravitational_parameter of the primary, the body moves in a straight line if it is not positive
+    @param duration time to advance by, may be negative
+    */
+    void propagate_universal(
+            StateVector2D &state,
+            const double standard_gravitational_parameter,
+            const double duration
+    );
+
+    /**
+    propagate_universal for count bodies, split across the job pool.
+
+    Bodies are solved 8 at a time with one iteration count per group, the way kepler::ecc_anomaly_batch does it,
+    so a mix of elliptic, parabolic and hyperbolic bodies runs the same straight line code on every lane.
+    */
+    void propagate_universal_batch(
+            const int count,
+            StateVector2D *states,
+            const double *standard_gravitational_parameters,
+            const double duration
+    );
+
+}
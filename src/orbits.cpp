@@ -1,22 +1,260 @@
+#include <cmath>
+#include <complex>
+
 #include "kepler.hpp"
 #include "orbits.hpp"
 
 namespace orbits {
 
+    namespace {
+        const double two_pi_hi = 6.28318530717958623200e+00;  // 2 pi rounded to double
+        const double two_pi_lo = 2.44929359829470635445e-16;  // 2 pi - two_pi_hi
+
+        /**
+        The product a * b as the unevaluated sum hi + lo, exact (Dekker's product with Veltkamp splitting).
+        Plain arithmetic rather than std::fma, which is a slow libm call on x86-64 builds without FMA.
+        */
+        inline void two_product(const double a, const double b, double &hi, double &lo) {
+            const double split = 134217729.0;  // 2^27 + 1
+            const double a_split = a * split;
+            const double a_hi = a_split - (a_split - a);
+            const double a_lo = a - a_hi;
+            const double b_split = b * split;
+            const double b_hi = b_split - (b_split - b);
+            const double b_lo = b - b_hi;
+            hi = a * b;
+            lo = ((a_hi * b_hi - hi) + a_hi * b_lo + a_lo * b_hi) + a_lo * b_lo;
+        }
+
+        /**
+        mean_anomaly_at_epoch + mean_angular_motion * (time - epoch) reduced to [0, 2 pi).
+        The elapsed time, its product with the mean motion and the whole turns subtracted from that are all kept
+        exact, so no precision is lost however large time gets. fmod of the rounded product instead inherits a
+        rounding error that grows with the number of turns.
+        */
+        inline double reduce_mean_anomaly(const double mean_angular_motion, const double time, const double epoch,
+                                          const double mean_anomaly_at_epoch) {
+            // time - epoch as elapsed + elapsed_error (Knuth's two-sum)
+            const double elapsed = time - epoch;
+            const double time_part = elapsed + epoch;
+            const double elapsed_error = (time - time_part) + (-epoch - (elapsed - time_part));
+
+            double product, product_error;
+            two_product(mean_angular_motion, elapsed, product, product_error);
+            product_error += mean_angular_motion * elapsed_error;
+            const double turns = std::floor((product + mean_anomaly_at_epoch) / two_pi_hi);
+            double turns_hi, turns_lo;
+            two_product(turns, two_pi_hi, turns_hi, turns_lo);
+            // product and turns_hi are within a turn of each other, so their difference is exact
+            double M = ((product - turns_hi) + mean_anomaly_at_epoch)
+                    + ((product_error - turns_lo) - turns * two_pi_lo);
+            // The floor above saw rounded values and can be one turn off right at the boundary
+            if (M < 0.0) M += 2.0 * M_PI;
+            if (M >= 2.0 * M_PI) M -= 2.0 * M_PI;
+            return M;
+        }
+
+        // An ellipse as centroid + a cos(E) major + b sin(E) minor, with major and minor the unit axis directions
+        struct Ellipse {
+            double cx, cy;
+            double major_x, major_y;
+            double minor_x, minor_y;
+            double a, b;
+        };
+
+        Ellipse get_ellipse(const OrbitElements &elements, const godot::Vector2 focus) {
+            const double e = elements.eccentricity;
+            const double w = elements.argument_of_periapsis;
+            Ellipse ellipse;
+            ellipse.a = elements.semi_major_axis;
+            ellipse.b = ellipse.a * std::sqrt(1.0 - e * e);
+            ellipse.major_x = std::cos(w);
+            ellipse.major_y = std::sin(w);
+            ellipse.minor_x = -ellipse.major_y;
+            ellipse.minor_y = ellipse.major_x;
+            ellipse.cx = focus.x - e * ellipse.a * ellipse.major_x;
+            ellipse.cy = focus.y - e * ellipse.a * ellipse.major_y;
+            return ellipse;
+        }
+
+        /**
+        The implicit equation of ellipse 2, u^2 + v^2 - 1 = 0, evaluated along ellipse 1. (u, v) are the coordinates
+        of the point at eccentric anomaly E of ellipse 1 in the frame of ellipse 2, scaled by its semi-axes, and
+        both are of the form u0 + uc cos E + us sin E.
+        */
+        struct InterceptEquation {
+            double u0, uc, us;
+            double v0, vc, vs;
+
+            InterceptEquation(const Ellipse &e1, const Ellipse &e2) {
+                const double dx = e1.cx - e2.cx;
+                const double dy = e1.cy - e2.cy;
+                u0 = (dx * e2.major_x + dy * e2.major_y) / e2.a;
+                uc = e1.a * (e1.major_x * e2.major_x + e1.major_y * e2.major_y) / e2.a;
+                us = e1.b * (e1.minor_x * e2.major_x + e1.minor_y * e2.major_y) / e2.a;
+                v0 = (dx * e2.minor_x + dy * e2.minor_y) / e2.b;
+                vc = e1.a * (e1.major_x * e2.minor_x + e1.major_y * e2.minor_y) / e2.b;
+                vs = e1.b * (e1.minor_x * e2.minor_x + e1.minor_y * e2.minor_y) / e2.b;
+            }
+
+            double value(const double E, double &derivative) const {
+                const double sin_E = std::sin(E);
+                const double cos_E = std::cos(E);
+                const double u = u0 + uc * cos_E + us * sin_E;
+                const double v = v0 + vc * cos_E + vs * sin_E;
+                derivative = 2.0 * (u * (us * cos_E - uc * sin_E) + v * (vs * cos_E - vc * sin_E));
+                return u * u + v * v - 1.0;
+            }
+
+            /**
+            Coefficients, lowest order first, of the equation multiplied by (1 + t^2)^2 with t = tan(E / 2).
+            */
+            void quartic(double *c) const {
+                // u (1 + t^2) = (u0 - uc) t^2 + 2 us t + (u0 + uc), and the same for v
+                const double u2 = u0 - uc, u1 = 2.0 * us, u_0 = u0 + uc;
+                const double v2 = v0 - vc, v1 = 2.0 * vs, v_0 = v0 + vc;
+                c[0] = u_0 * u_0 + v_0 * v_0 - 1.0;
+                c[1] = 2.0 * (u_0 * u1 + v_0 * v1);
+                c[2] = u1 * u1 + 2.0 * u_0 * u2 + v1 * v1 + 2.0 * v_0 * v2 - 2.0;
+                c[3] = 2.0 * (u1 * u2 + v1 * v2);
+                c[4] = u2 * u2 + v2 * v2 - 1.0;
+            }
+        };
+
+        /**
+        All complex roots of the polynomial c[0] + c[1] x + ... + c[degree] x^degree by Durand-Kerner iteration.
+        */
+        void solve_polynomial(const double *c, const int degree, std::complex<double> *roots) {
+            // Every root lies within this radius (Cauchy bound), spread the starting points around it
+            double radius = 0.0;
+            for (int i = 0; i < degree; i++) {
+                radius = std::fmax(radius, std::abs(c[i] / c[degree]));
+            }
+            radius += 1.0;
+            for (int k = 0; k < degree; k++) {
+                roots[k] = std::polar(radius, 2.0 * M_PI * k / degree + 0.4);
+            }
+
+            for (int iteration = 0; iteration < 500; iteration++) {
+                double max_step = 0.0;
+                for (int k = 0; k < degree; k++) {
+                    std::complex<double> p = c[degree];
+                    for (int i = degree - 1; i >= 0; i--) {
+                        p = p * roots[k] + c[i];
+                    }
+                    std::complex<double> q = c[degree];
+                    for (int j = 0; j < degree; j++) {
+                        if (j != k) q *= roots[k] - roots[j];
+                    }
+                    if (q == 0.0) continue;
+                    const std::complex<double> step = p / q;
+                    roots[k] -= step;
+                    max_step = std::fmax(max_step, std::abs(step) / (1.0 + std::abs(roots[k])));
+                }
+                if (max_step < 1e-15) break;
+            }
+        }
+    }
+
+    OrbitElements get_orbit_elements(
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis,
+            const float standard_gravitational_parameter
+    ) {
+        return get_orbit_elements(eccentricity, semi_major_axis, argument_of_periapsis,
+                                  standard_gravitational_parameter, 0.0, 0.0);
+    }
+
+    OrbitElements get_orbit_elements(
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis,
+            const float standard_gravitational_parameter,
+            const double epoch,
+            const double mean_anomaly_at_epoch
+    ) {
+        OrbitElements elements;
+        elements.eccentricity = eccentricity;
+        elements.semi_major_axis = semi_major_axis;
+        elements.argument_of_periapsis = argument_of_periapsis;
+        elements.standard_gravitational_parameter = standard_gravitational_parameter;
+
+        elements.sqrt_one_minus_e2 = std::sqrt(1.0f - eccentricity * eccentricity);
+        elements.true_anomaly_factor = std::sqrt(1.0f + eccentricity) / std::sqrt(1.0f - eccentricity);
+        elements.semi_minor_axis = semi_major_axis * elements.sqrt_one_minus_e2;
+        elements.linear_eccentricity = eccentricity * semi_major_axis;
+        const double a = semi_major_axis;
+        elements.mean_angular_motion = std::sqrt(standard_gravitational_parameter / (a * a * a));
+        elements.orbital_period = 2.0 * M_PI / elements.mean_angular_motion;
+        elements.epoch = epoch;
+        elements.mean_anomaly_at_epoch = mean_anomaly_at_epoch
+                - 2.0 * M_PI * std::floor(mean_anomaly_at_epoch / (2.0 * M_PI));
+        elements.sin_argument_of_periapsis = std::sin(argument_of_periapsis);
+        elements.cos_argument_of_periapsis = std::cos(argument_of_periapsis);
+        elements.sqrt_mu_a = std::sqrt(standard_gravitational_parameter * semi_major_axis);
+        return elements;
+    }
+
+    bool get_orbit_elements_from_state(
+            const godot::Vector2 position,
+            const godot::Vector2 velocity,
+            const float standard_gravitational_parameter,
+            const double time,
+            OrbitElements &elements
+    ) {
+        const double mu = standard_gravitational_parameter;
+        const double x = position.x, y = position.y;
+        const double vx = velocity.x, vy = velocity.y;
+        const double r = std::sqrt(x * x + y * y);
+        const double v2 = vx * vx + vy * vy;
+        const double angular_momentum = x * vy - y * vx;
+        const double energy = 0.5 * v2 - mu / r;
+        if (!(r > 0.0) || !(angular_momentum > 0.0) || !(energy < 0.0)) return false;
+
+        // Eccentricity vector, pointing at periapsis
+        const double a = -mu / (2.0 * energy);
+        const double r_dot_v = x * vx + y * vy;
+        const double ex = ((v2 - mu / r) * x - r_dot_v * vx) / mu;
+        const double ey = ((v2 - mu / r) * y - r_dot_v * vy) / mu;
+        const double e = std::sqrt(ex * ex + ey * ey);
+        if (!(e < 1.0)) return false;
+
+        // Position in the frame of the orbit, a (cos E - e) along periapsis and b sin E across it. Read off E from
+        // both coordinates, which stays well defined on a circle where periapsis is arbitrary.
+        const double w = e > 0.0 ? std::atan2(ey, ex) : 0.0;
+        const double cos_w = std::cos(w), sin_w = std::sin(w);
+        const double px = x * cos_w + y * sin_w;
+        const double py = y * cos_w - x * sin_w;
+        const double E = std::atan2(py / (a * std::sqrt(1.0 - e * e)), px / a + e);
+
+        elements = get_orbit_elements(static_cast<float>(e), static_cast<float>(a), static_cast<float>(w),
+                                      standard_gravitational_parameter, time, E - e * std::sin(E));
+        return true;
+    }
+
     float get_semi_minor_axis(const float eccentricity, const float semi_major_axis) {
-        return godot::Math::sqrt(
-                pow(semi_major_axis, 2.0) - pow(get_linear_eccentricity(eccentricity, semi_major_axis), 2.0));
+        return get_semi_minor_axis<float>(eccentricity, semi_major_axis);
     }
 
     float get_linear_eccentricity(const float eccentricity, const float semi_major_axis) {
-        return eccentricity * semi_major_axis;
+        return get_linear_eccentricity<float>(eccentricity, semi_major_axis);
     }
 
     float get_geocentric_distance(
             const float standard_gravitational_parameter,
             const float rotational_period
     ) {
-        return pow(standard_gravitational_parameter * pow(rotational_period, 2.0) / (4.0 * pow(M_PI, 2.0)), 1.0 / 3.0);
+        return get_geocentric_distance<float>(standard_gravitational_parameter, rotational_period);
+    }
+
+    float get_sphere_of_influence_radius(
+            const float semi_major_axis,
+            const float standard_gravitational_parameter,
+            const float primary_standard_gravitational_parameter
+    ) {
+        return get_sphere_of_influence_radius<float>(semi_major_axis, standard_gravitational_parameter,
+                                                     primary_standard_gravitational_parameter);
     }
 
     godot::Vector2 get_focus_point_from_centroid(
@@ -27,8 +265,8 @@ namespace orbits {
     ) {
         float le = get_linear_eccentricity(eccentricity, semi_major_axis);
         return godot::Vector2{
-                le * godot::Math::sin(argument_of_periapsis) + centroid.x,
-                le * godot::Math::cos(argument_of_periapsis) + centroid.y
+                le * godot::Math::cos(argument_of_periapsis) + centroid.x,
+                le * godot::Math::sin(argument_of_periapsis) + centroid.y
         };
     }
 
@@ -40,70 +278,69 @@ namespace orbits {
     ) {
         float le = get_linear_eccentricity(eccentricity, semi_major_axis);
         return godot::Vector2{
-            focus.x - le * godot::Math::sin(argument_of_periapsis),
-            focus.y - le * godot::Math::cos(argument_of_periapsis)
+            focus.x - le * godot::Math::cos(argument_of_periapsis),
+            focus.y - le * godot::Math::sin(argument_of_periapsis)
         };
     }
 
     float get_orbital_period(const float semi_major_axis, const float standard_gravitational_parameter) {
-        return 2.0 * M_PI * (godot::Math::sqrt(pow(semi_major_axis, 3.0) / standard_gravitational_parameter));
+        return get_orbital_period<float>(semi_major_axis, standard_gravitational_parameter);
     }
 
     float get_mean_angular_motion(const float semi_major_axis, const float standard_gravitational_parameter) {
-        return 2.0 * M_PI / get_orbital_period(semi_major_axis, standard_gravitational_parameter);
+        return get_mean_angular_motion<float>(semi_major_axis, standard_gravitational_parameter);
     }
 
     float
     get_mean_anomaly(const float time, const float semi_major_axis, const float standard_gravitational_parameter) {
-        return get_mean_angular_motion(semi_major_axis, standard_gravitational_parameter) * time;
+        return get_mean_anomaly<float>(time, semi_major_axis, standard_gravitational_parameter);
     }
 
-    float get_eccentric_anomaly_from_mean_anomaly(const float mean_anomaly, const float eccentricity,
-                                                  const float argument_of_periapsis) {
-        return kepler::ecc_anomaly(eccentricity, mean_anomaly) + argument_of_periapsis;
+    float get_eccentric_anomaly_from_mean_anomaly(const float mean_anomaly, const float eccentricity) {
+        return get_eccentric_anomaly_from_mean_anomaly<float>(mean_anomaly, eccentricity);
     }
 
     float get_eccentric_anomaly_from_position(
             const godot::Vector2 position,
-            const godot::Vector2 focus_point
+            const godot::Vector2 focus_point,
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis
     ) {
-        return focus_point.angle_to(position);
+        return get_eccentric_anomaly_from_position(position, focus_point,
+                                                   get_orbit_elements(eccentricity, semi_major_axis,
+                                                                      argument_of_periapsis, 1.0));
     }
 
     float get_eccentric_anomaly(const float time, const float eccentricity, const float semi_major_axis,
-                                const float argument_of_periapsis,
+                                const float /* argument_of_periapsis */,
                                 const float standard_gravitational_parameter) {
-        float mean_anomaly = get_mean_anomaly(time, semi_major_axis, standard_gravitational_parameter);
-        return get_eccentric_anomaly_from_mean_anomaly(mean_anomaly, eccentricity, argument_of_periapsis);
+        return get_eccentric_anomaly<float>(time, eccentricity, semi_major_axis, standard_gravitational_parameter);
     }
 
     float get_true_anomaly_from_eccentric_anomaly(const float eccentric_anomaly, const float eccentricity) {
-        const float E = eccentric_anomaly;
-        return 2.0 * godot::Math::atan2(godot::Math::sqrt(1.0 + eccentricity) * godot::Math::sin(E / 2.0),
-                                        godot::Math::sqrt(1.0 - eccentricity) * godot::Math::cos(E / 2.0));
+        return get_true_anomaly_from_eccentric_anomaly<float>(eccentric_anomaly, eccentricity);
     }
 
     float get_true_anomaly_from_time(const float time, const float eccentricity, const float semi_major_axis,
-                                     const float argument_of_periapsis,
+                                     const float /* argument_of_periapsis */,
                                      const float standard_gravitational_parameter) {
-        float E = get_eccentric_anomaly(time, eccentricity, semi_major_axis, argument_of_periapsis,
-                                        standard_gravitational_parameter);
-        return get_true_anomaly_from_eccentric_anomaly(E, eccentricity);
+        return get_true_anomaly_from_time<float>(time, eccentricity, semi_major_axis,
+                                                 standard_gravitational_parameter);
     }
 
     float
     get_heliocentric_distance_from_eccentric_anomaly(const float eccentric_anomaly, const float eccentricity,
                                                      const float semi_major_axis) {
-        return semi_major_axis * (1.0 - eccentricity * godot::Math::cos(eccentric_anomaly));
+        return get_heliocentric_distance_from_eccentric_anomaly<float>(eccentric_anomaly, eccentricity, semi_major_axis);
     }
 
     float
     get_heliocentric_distance_from_time(const float time, const float eccentricity, const float semi_major_axis,
-                                        const float argument_of_periapsis,
+                                        const float /* argument_of_periapsis */,
                                         const float standard_gravitational_parameter) {
-        float eccentric_anomaly = get_eccentric_anomaly(time, eccentricity, semi_major_axis, argument_of_periapsis,
-                                                        standard_gravitational_parameter);
-        return get_heliocentric_distance_from_eccentric_anomaly(eccentric_anomaly, eccentricity, semi_major_axis);
+        return get_heliocentric_distance_from_time<float>(time, eccentricity, semi_major_axis,
+                                                          standard_gravitational_parameter);
     }
 
     godot::Vector2
@@ -115,7 +352,7 @@ namespace orbits {
         float scale = godot::Math::sqrt(standard_gravitational_parameter * semi_major_axis) / heliocentric_distance;
         return godot::Vector2(
                 scale * -godot::Math::sin(eccentric_anomaly),
-                scale * godot::Math::sqrt(1.0 - pow(eccentricity, 2.0)) * godot::Math::cos(eccentric_anomaly)
+                scale * godot::Math::sqrt(1.0f - eccentricity * eccentricity) * godot::Math::cos(eccentric_anomaly)
         );
     }
 
@@ -126,27 +363,29 @@ namespace orbits {
         float eccentric_anomaly = get_eccentric_anomaly(time, eccentricity, semi_major_axis, argument_of_periapsis,
                                                         standard_gravitational_parameter);
         return get_heliocentric_velocity_from_eccentric_anomaly(eccentric_anomaly, eccentricity, semi_major_axis,
-                                                                standard_gravitational_parameter);
+                                                                standard_gravitational_parameter)
+                .rotated(argument_of_periapsis);
     }
 
     PositionVelocity2D
     get_heliocentric_position_velocity_from_eccentric_anomaly(const float eccentric_anomaly, const float eccentricity,
                                                               const float semi_major_axis,
+                                                              const float argument_of_periapsis,
                                                               const float standard_gravitational_parameter) {
         float heliocentric_distance = get_heliocentric_distance_from_eccentric_anomaly(eccentric_anomaly, eccentricity,
                                                                                        semi_major_axis);
         float scale = godot::Math::sqrt(standard_gravitational_parameter * semi_major_axis) / heliocentric_distance;
         godot::Vector2 v = godot::Vector2(
                 scale * -godot::Math::sin(eccentric_anomaly),
-                scale * godot::Math::sqrt(1.0 - pow(eccentricity, 2.0)) * godot::Math::cos(eccentric_anomaly)
+                scale * godot::Math::sqrt(1.0f - eccentricity * eccentricity) * godot::Math::cos(eccentric_anomaly)
         );
-        float distance = semi_major_axis * (1.0 - eccentricity * godot::Math::cos(eccentric_anomaly));
+        float distance = semi_major_axis * (1.0f - eccentricity * godot::Math::cos(eccentric_anomaly));
         float true_anomaly = get_true_anomaly_from_eccentric_anomaly(eccentric_anomaly, eccentricity);
         godot::Vector2 p = godot::Vector2(
                 distance * godot::Math::cos(true_anomaly),
                 distance * godot::Math::sin(true_anomaly)
         );
-        return PositionVelocity2D{p, v};
+        return PositionVelocity2D{p.rotated(argument_of_periapsis), v.rotated(argument_of_periapsis)};
     }
 
     PositionVelocity2D get_heliocentric_position_velocity_from_time(const float time, const float eccentricity,
@@ -156,10 +395,68 @@ namespace orbits {
         float eccentric_anomaly = get_eccentric_anomaly(time, eccentricity, semi_major_axis, argument_of_periapsis,
                                                         standard_gravitational_parameter);
         return get_heliocentric_position_velocity_from_eccentric_anomaly(eccentric_anomaly, eccentricity,
-                                                                         semi_major_axis,
+                                                                         semi_major_axis, argument_of_periapsis,
                                                                          standard_gravitational_parameter);
     }
 
+    void get_heliocentric_position_velocity_from_time_batch(const int count, const float *time,
+                                                            const float *eccentricity,
+                                                            const float *semi_major_axis,
+                                                            const float *argument_of_periapsis,
+                                                            const float *standard_gravitational_parameter,
+                                                            godot::Vector2 *positions,
+                                                            godot::Vector2 *velocities) {
+        // Bodies are processed in fixed size blocks so the element-wise passes below stay branch free and can
+        // be vectorized, with the Kepler solve for the whole block handed to the vectorized solver.
+        const int block_size = 64;
+        double block_eccentricity[block_size];
+        double mean_anomaly[block_size];
+        double eccentric_anomaly[block_size];
+
+        for (int start = 0; start < count; start += block_size) {
+            const int n = count - start < block_size ? count - start : block_size;
+            const float *t = time + start;
+            const float *e = eccentricity + start;
+            const float *a = semi_major_axis + start;
+            const float *w = argument_of_periapsis + start;
+            const float *mu = standard_gravitational_parameter + start;
+
+            for (int i = 0; i < n; i++) {
+                block_eccentricity[i] = e[i];
+                mean_anomaly[i] = std::sqrt(mu[i] / (a[i] * a[i] * a[i])) * t[i];
+            }
+            kepler::ecc_anomaly_batch(block_eccentricity, mean_anomaly, eccentric_anomaly, n);
+            for (int i = 0; i < n; i++) {
+                const float sin_E = std::sin(eccentric_anomaly[i]);
+                const float cos_E = std::cos(eccentric_anomaly[i]);
+                const float sin_w = std::sin(w[i]);
+                const float cos_w = std::cos(w[i]);
+                const float root_one_minus_e2 = std::sqrt(1.0f - e[i] * e[i]);
+
+                // Position in the perifocal frame, r * (cos(nu), sin(nu)) written in terms of E
+                const float px = a[i] * (cos_E - e[i]);
+                const float py = a[i] * root_one_minus_e2 * sin_E;
+                const float scale = std::sqrt(mu[i] * a[i]) / (a[i] * (1.0f - e[i] * cos_E));
+                const float vx = -scale * sin_E;
+                const float vy = scale * root_one_minus_e2 * cos_E;
+
+                positions[start + i] = godot::Vector2(px * cos_w - py * sin_w, px * sin_w + py * cos_w);
+                velocities[start + i] = godot::Vector2(vx * cos_w - vy * sin_w, vx * sin_w + vy * cos_w);
+            }
+        }
+    }
+
+    int find_intercept_points(const float eccentricity1, const float semi_major_axis1,
+                              const float argument_of_periapsis1, const float eccentricity2,
+                              const float semi_major_axis2, const float argument_of_periapsis2,
+                              godot::Vector2 *points) {
+        return find_intercept_points(
+                get_orbit_elements(eccentricity1, semi_major_axis1, argument_of_periapsis1, 1.0), godot::Vector2(),
+                get_orbit_elements(eccentricity2, semi_major_axis2, argument_of_periapsis2, 1.0), godot::Vector2(),
+                points
+        );
+    }
+
     bool is_circle(float eccentricity) {
         return eccentricity == 0.0;
     }
@@ -176,4 +473,301 @@ namespace orbits {
         return eccentricity > 1.0;
     }
 
-}
\ No newline at end of file
+    // OrbitElements overloads
+
+    float get_semi_minor_axis(const OrbitElements &elements) {
+        return elements.semi_minor_axis;
+    }
+
+    float get_linear_eccentricity(const OrbitElements &elements) {
+        return elements.linear_eccentricity;
+    }
+
+    godot::Vector2 get_focus_point_from_centroid(const OrbitElements &elements, const godot::Vector2 centroid) {
+        return godot::Vector2{
+                elements.linear_eccentricity * elements.cos_argument_of_periapsis + centroid.x,
+                elements.linear_eccentricity * elements.sin_argument_of_periapsis + centroid.y
+        };
+    }
+
+    godot::Vector2 get_centroid_from_focus_point(const OrbitElements &elements, const godot::Vector2 focus) {
+        return godot::Vector2{
+                focus.x - elements.linear_eccentricity * elements.cos_argument_of_periapsis,
+                focus.y - elements.linear_eccentricity * elements.sin_argument_of_periapsis
+        };
+    }
+
+    float get_orbital_period(const OrbitElements &elements) {
+        return elements.orbital_period;
+    }
+
+    float get_mean_angular_motion(const OrbitElements &elements) {
+        return elements.mean_angular_motion;
+    }
+
+    double get_mean_anomaly(const double time, const OrbitElements &elements) {
+        return reduce_mean_anomaly(elements.mean_angular_motion, time, elements.epoch,
+                                   elements.mean_anomaly_at_epoch);
+    }
+
+    // Positions from elements feed the simulation, events and contact searches as well as drawing, so they are
+    // solved in double like the batch and table paths, and only rounded to float at the end
+    float get_eccentric_anomaly_from_mean_anomaly(const float mean_anomaly, const OrbitElements &elements) {
+        return kepler::ecc_anomaly<double>(elements.eccentricity, mean_anomaly);
+    }
+
+    float get_eccentric_anomaly(const double time, const OrbitElements &elements) {
+        return kepler::ecc_anomaly<double>(elements.eccentricity, get_mean_anomaly(time, elements));
+    }
+
+    float get_eccentric_anomaly_from_position(const godot::Vector2 position, const godot::Vector2 focus_point,
+                                              const OrbitElements &elements) {
+        // In the frame of the orbit the position is a (cos E - e) along periapsis and b sin E across it
+        const godot::Vector2 offset = position - focus_point;
+        const float x = offset.x * elements.cos_argument_of_periapsis + offset.y * elements.sin_argument_of_periapsis;
+        const float y = offset.y * elements.cos_argument_of_periapsis - offset.x * elements.sin_argument_of_periapsis;
+        return std::atan2(y / elements.semi_minor_axis, x / elements.semi_major_axis + elements.eccentricity);
+    }
+
+    float get_true_anomaly_from_eccentric_anomaly(const float eccentric_anomaly, const OrbitElements &elements) {
+        return 2.0 * std::atan2(elements.true_anomaly_factor * std::sin(eccentric_anomaly / 2.0f),
+                                std::cos(eccentric_anomaly / 2.0f));
+    }
+
+    float get_true_anomaly_from_time(const double time, const OrbitElements &elements) {
+        return get_true_anomaly_from_eccentric_anomaly(get_eccentric_anomaly(time, elements), elements);
+    }
+
+    float get_heliocentric_distance_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    ) {
+        return elements.semi_major_axis * (1.0f - elements.eccentricity * std::cos(eccentric_anomaly));
+    }
+
+    float get_heliocentric_distance_from_time(const double time, const OrbitElements &elements) {
+        return get_heliocentric_distance_from_eccentric_anomaly(get_eccentric_anomaly(time, elements), elements);
+    }
+
+    godot::Vector2 get_heliocentric_velocity_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    ) {
+        const float sin_E = std::sin(eccentric_anomaly);
+        const float cos_E = std::cos(eccentric_anomaly);
+        const float scale = elements.sqrt_mu_a / (elements.semi_major_axis * (1.0f - elements.eccentricity * cos_E));
+        return godot::Vector2(-scale * sin_E, scale * elements.sqrt_one_minus_e2 * cos_E);
+    }
+
+    godot::Vector2 get_heliocentric_velocity_from_time(const double time, const OrbitElements &elements) {
+        const godot::Vector2 v = get_heliocentric_velocity_from_eccentric_anomaly(
+                get_eccentric_anomaly(time, elements), elements);
+        return godot::Vector2(
+                v.x * elements.cos_argument_of_periapsis - v.y * elements.sin_argument_of_periapsis,
+                v.x * elements.sin_argument_of_periapsis + v.y * elements.cos_argument_of_periapsis
+        );
+    }
+
+    PositionVelocity2D get_heliocentric_position_velocity_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    ) {
+        const float sin_E = std::sin(eccentric_anomaly);
+        const float cos_E = std::cos(eccentric_anomaly);
+        const float sin_w = elements.sin_argument_of_periapsis;
+        const float cos_w = elements.cos_argument_of_periapsis;
+
+        const float px = elements.semi_major_axis * (cos_E - elements.eccentricity);
+        const float py = elements.semi_minor_axis * sin_E;
+        const float scale = elements.sqrt_mu_a / (elements.semi_major_axis * (1.0f - elements.eccentricity * cos_E));
+        const float vx = -scale * sin_E;
+        const float vy = scale * elements.sqrt_one_minus_e2 * cos_E;
+
+        return PositionVelocity2D{
+                godot::Vector2(px * cos_w - py * sin_w, px * sin_w + py * cos_w),
+                godot::Vector2(vx * cos_w - vy * sin_w, vx * sin_w + vy * cos_w)
+        };
+    }
+
+    PositionVelocity2D get_heliocentric_position_velocity_from_time(const double time, const OrbitElements &elements) {
+        return get_heliocentric_position_velocity_from_eccentric_anomaly(get_eccentric_anomaly(time, elements),
+                                                                         elements);
+    }
+
+    void get_heliocentric_position_velocity_from_time_batch(const int count, const double *time,
+                                                            const OrbitElements *elements,
+                                                            godot::Vector2 *positions,
+                                                            godot::Vector2 *velocities) {
+        const int block_size = 64;
+        double block_eccentricity[block_size];
+        double mean_anomaly[block_size];
+        double eccentric_anomaly[block_size];
+
+        for (int start = 0; start < count; start += block_size) {
+            const int n = count - start < block_size ? count - start : block_size;
+            const OrbitElements *el = elements + start;
+
+            for (int i = 0; i < n; i++) {
+                block_eccentricity[i] = el[i].eccentricity;
+                mean_anomaly[i] = reduce_mean_anomaly(el[i].mean_angular_motion, time[start + i], el[i].epoch,
+                                                      el[i].mean_anomaly_at_epoch);
+            }
+            kepler::ecc_anomaly_batch(block_eccentricity, mean_anomaly, eccentric_anomaly, n);
+            for (int i = 0; i < n; i++) {
+                const PositionVelocity2D pv = get_heliocentric_position_velocity_from_eccentric_anomaly(
+                        eccentric_anomaly[i], el[i]);
+                positions[start + i] = pv.p;
+                velocities[start + i] = pv.v;
+            }
+        }
+    }
+
+    void get_ellipse_points(const OrbitElements &elements, const int count, godot::Vector2 *points) {
+        const godot::Vector2 centroid = get_centroid_from_focus_point(elements, godot::Vector2());
+        const float a_cos_w = elements.semi_major_axis * elements.cos_argument_of_periapsis;
+        const float a_sin_w = elements.semi_major_axis * elements.sin_argument_of_periapsis;
+        const float b_cos_w = elements.semi_minor_axis * elements.cos_argument_of_periapsis;
+        const float b_sin_w = elements.semi_minor_axis * elements.sin_argument_of_periapsis;
+
+        // Step (cos(theta), sin(theta)) around the circle by complex multiplication instead of calling sin and
+        // cos per point. Kept in double so the rounding error does not build up over a few thousand steps.
+        const double step = 2.0 * M_PI / count;
+        const double cos_step = std::cos(step);
+        const double sin_step = std::sin(step);
+        double cos_theta = 1.0;
+        double sin_theta = 0.0;
+        for (int i = 0; i < count; i++) {
+            points[i] = godot::Vector2(
+                    centroid.x + a_cos_w * cos_theta - b_sin_w * sin_theta,
+                    centroid.y + a_sin_w * cos_theta + b_cos_w * sin_theta
+            );
+            const double next_cos = cos_theta * cos_step - sin_theta * sin_step;
+            sin_theta = sin_theta * cos_step + cos_theta * sin_step;
+            cos_theta = next_cos;
+        }
+    }
+
+    int get_adaptive_ellipse_points(const OrbitElements &elements, const float scale, const float max_error,
+                                    const int max_count, godot::Vector2 *points) {
+        const double a = elements.semi_major_axis;
+        const double b = elements.semi_minor_axis;
+        const double tolerance = max_error / scale;
+        const godot::Vector2 centroid = get_centroid_from_focus_point(elements, godot::Vector2());
+        const double sin_w = elements.sin_argument_of_periapsis;
+        const double cos_w = elements.cos_argument_of_periapsis;
+
+        // A chord of length L on a circle of radius rho deviates from it by L^2 / (8 rho). With the radius of
+        // curvature rho(E) = s(E)^3 / (a b) and arc speed s(E) = sqrt(a^2 sin^2 E + b^2 cos^2 E) this gives a
+        // step in eccentric anomaly of sqrt(8 tolerance s(E) / (a b)): short steps around the ends of the major
+        // axis, where the curvature peaks, and long ones along the flanks. The curvature is sampled at the start
+        // of each step, so 6 is used instead of 8 to leave headroom where it grows along the step.
+        const double step_factor = a * b > 0.0 ? std::sqrt(6.0 * tolerance / (a * b)) : 0.0;
+        const double min_step = 2.0 * M_PI / max_count;
+        const double max_step = M_PI / 4.0;
+
+        int count = 0;
+        double E = 0.0;
+        while (E < 2.0 * M_PI && count < max_count) {
+            const double sin_E = std::sin(E);
+            const double cos_E = std::cos(E);
+            if (points) {
+                const double x = a * cos_E;
+                const double y = b * sin_E;
+                points[count] = godot::Vector2(
+                        centroid.x + x * cos_w - y * sin_w,
+                        centroid.y + x * sin_w + y * cos_w
+                );
+            }
+            count++;
+
+            const double speed = std::sqrt(a * a * sin_E * sin_E + b * b * cos_E * cos_E);
+            double step = step_factor * std::sqrt(speed);
+            step = step < min_step ? min_step : (step > max_step ? max_step : step);
+            E += step;
+        }
+        return count;
+    }
+
+    int find_intercept_points(const OrbitElements &elements1, const godot::Vector2 focus1,
+                              const OrbitElements &elements2, const godot::Vector2 focus2, godot::Vector2 *points) {
+        if (elements1.eccentricity >= 1.0 || elements2.eccentricity >= 1.0) return 0;
+        if (elements1.semi_major_axis <= 0.0 || elements2.semi_major_axis <= 0.0) return 0;
+
+        const Ellipse ellipse1 = get_ellipse(elements1, focus1);
+        const Ellipse ellipse2 = get_ellipse(elements2, focus2);
+        const InterceptEquation equation(ellipse1, ellipse2);
+
+        double c[5];
+        equation.quartic(c);
+        double max_coefficient = 0.0;
+        for (int i = 0; i < 5; i++) {
+            max_coefficient = std::fmax(max_coefficient, std::abs(c[i]));
+        }
+        // The equation vanishes everywhere when the orbits coincide
+        if (max_coefficient < 1e-12) return 0;
+
+        // A vanishing leading coefficient means a root at t = infinity, which is E = pi
+        int degree = 4;
+        while (degree > 0 && std::abs(c[degree]) <= 1e-12 * max_coefficient) degree--;
+
+        double candidates[5];
+        int candidate_count = 0;
+        std::complex<double> roots[4];
+        solve_polynomial(c, degree, roots);
+        for (int i = 0; i < degree; i++) {
+            // Loose on purpose, a grazing contact shows up as a nearly real pair and Newton's method below decides
+            if (std::abs(roots[i].imag()) <= 1e-4 * (1.0 + std::abs(roots[i]))) {
+                candidates[candidate_count++] = 2.0 * std::atan(roots[i].real());
+            }
+        }
+        if (degree < 4) candidates[candidate_count++] = M_PI;
+
+        double anomalies[4];
+        int count = 0;
+        for (int i = 0; i < candidate_count; i++) {
+            double E = candidates[i];
+            double derivative;
+            double value = equation.value(E, derivative);
+            for (int iteration = 0; iteration < 16 && derivative != 0.0; iteration++) {
+                const double step = value / derivative;
+                E -= step;
+                value = equation.value(E, derivative);
+                if (std::abs(step) < 1e-15) break;
+            }
+            if (std::abs(value) > 1e-8) continue;
+
+            E = std::remainder(E, 2.0 * M_PI);
+            bool duplicate = false;
+            for (int j = 0; j < count; j++) {
+                if (std::abs(std::remainder(E - anomalies[j], 2.0 * M_PI)) < 1e-7) duplicate = true;
+            }
+            if (duplicate || count == 4) continue;
+            anomalies[count] = E;
+
+            const double x = ellipse1.a * std::cos(E);
+            const double y = ellipse1.b * std::sin(E);
+            points[count] = godot::Vector2(
+                    ellipse1.cx + x * ellipse1.major_x + y * ellipse1.minor_x,
+                    ellipse1.cy + x * ellipse1.major_y + y * ellipse1.minor_y
+            );
+            count++;
+        }
+        return count;
+    }
+
+    bool is_circle(const OrbitElements &elements) {
+        return is_circle(elements.eccentricity);
+    }
+
+    bool is_ellipse(const OrbitElements &elements) {
+        return is_ellipse(elements.eccentricity);
+    }
+
+    bool is_parabola(const OrbitElements &elements) {
+        return is_parabola(elements.eccentricity);
+    }
+
+    bool is_hyperbola(const OrbitElements &elements) {
+        return is_hyperbola(elements.eccentricity);
+    }
+}
@@ -1,5 +1,9 @@
+#include <cmath>
+
 #include <Godot.hpp>
 
+#include "kepler.hpp"
+
 #pragma once
 
 namespace orbits {
@@ -9,6 +13,74 @@ namespace orbits {
         godot::Vector2 v;
     };
 
+    /**
+    The elements of an orbit together with the quantities every *_from_time function derives from them.
+    Build it with get_orbit_elements whenever an element changes and pass it to the OrbitElements overloads below,
+    which then cost no pow, sqrt or trig calls beyond the Kepler solve itself.
+
+    Time is measured from an epoch, at which the body had mean anomaly mean_anomaly_at_epoch. Both, and every time
+    passed to the OrbitElements overloads, are doubles, and the mean anomaly is reduced to one turn before it
+    reaches the float math, so positions stay exact however long the simulation runs.
+    */
+    struct OrbitElements {
+        float eccentricity;
+        float semi_major_axis;
+        float argument_of_periapsis;
+        float standard_gravitational_parameter;
+
+        float semi_minor_axis;
+        float linear_eccentricity;
+        float sqrt_one_minus_e2;      // sqrt(1 - e^2)
+        float true_anomaly_factor;    // sqrt(1 + e) / sqrt(1 - e)
+        float sin_argument_of_periapsis;
+        float cos_argument_of_periapsis;
+        float sqrt_mu_a;              // sqrt(standard_gravitational_parameter * semi_major_axis)
+
+        // In double, every float rounding of these would show up as a drift of the body along its orbit
+        double orbital_period;
+        double mean_angular_motion;
+        double epoch;
+        double mean_anomaly_at_epoch; // in [0, 2 pi)
+    };
+
+    /**
+    Elements of an orbit whose body passes periapsis at time 0.
+    */
+    OrbitElements get_orbit_elements(
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis,
+            const float standard_gravitational_parameter
+    );
+
+    /**
+    Elements of an orbit whose body has mean anomaly mean_anomaly_at_epoch (in radians, any branch) at time epoch.
+    */
+    OrbitElements get_orbit_elements(
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis,
+            const float standard_gravitational_parameter,
+            const double epoch,
+            const double mean_anomaly_at_epoch
+    );
+
+    /**
+    Elements of the orbit through position with velocity at time, around a primary at the origin, for re-fitting
+    a body to a new primary after it crosses into another sphere of influence. The elements are worked out in
+    double from the eccentricity vector and vis-viva, and the epoch is time.
+
+    @return false, leaving elements untouched, if the state is not on a bound orbit traversed counter-clockwise,
+            the only orbits OrbitElements describes
+    */
+    bool get_orbit_elements_from_state(
+            const godot::Vector2 position,
+            const godot::Vector2 velocity,
+            const float standard_gravitational_parameter,
+            const double time,
+            OrbitElements &elements
+    );
+
     float get_semi_minor_axis(
             const float eccentricity,
             const float semi_major_axis
@@ -24,6 +96,16 @@ namespace orbits {
             const float rotational_period
     );
 
+    /**
+    Radius of the sphere of influence, a (m / M)^(2/5), of a body on an orbit of semi_major_axis around a primary.
+    The masses only appear as a ratio, so the standard gravitational parameters stand in for them.
+    */
+    float get_sphere_of_influence_radius(
+            const float semi_major_axis,
+            const float standard_gravitational_parameter,
+            const float primary_standard_gravitational_parameter
+    );
+
     godot::Vector2 get_focus_point_from_centroid(
             const float eccentricity,
             const float semi_major_axis,
@@ -56,8 +138,7 @@ namespace orbits {
 
     float get_eccentric_anomaly_from_mean_anomaly(
             const float mean_anomaly,
-            const float eccentricity,
-            const float argument_of_periapsis
+            const float eccentricity
     );
 
     float get_eccentric_anomaly(
@@ -68,9 +149,17 @@ namespace orbits {
             const float standard_gravitational_parameter
     );
 
+    /**
+    Eccentric anomaly of a position on the orbit with its focus at focus_point. Points off the orbit map to the
+    anomaly of the point where the ellipse, scaled about its centre, passes through them, use get_nearest_point
+    for the anomaly of the closest point instead.
+    */
     float get_eccentric_anomaly_from_position(
             const godot::Vector2 position,
-            const godot::Vector2 focus_point
+            const godot::Vector2 focus_point,
+            const float eccentricity,
+            const float semi_major_axis,
+            const float argument_of_periapsis
     );
 
     float get_true_anomaly_from_eccentric_anomaly(
@@ -131,6 +220,48 @@ namespace orbits {
             const float standard_gravitational_parameter
     );
 
+    /**
+    Propagates count bodies at once from structure-of-arrays input.
+    Equivalent to calling get_heliocentric_position_velocity_from_time for every index i, with
+    positions[i] and velocities[i] receiving the p and v members of the result.
+
+    @param count number of bodies in every input and output array
+    @param time time since periapsis passage of each body
+    @param eccentricity eccentricity of each orbit
+    @param semi_major_axis semi-major axis of each orbit
+    @param argument_of_periapsis argument of periapsis of each orbit (in radians)
+    @param standard_gravitational_parameter standard gravitational parameter of each orbit's primary
+    @param positions output, heliocentric position of each body
+    @param velocities output, heliocentric velocity of each body
+    */
+    void get_heliocentric_position_velocity_from_time_batch(
+            const int count,
+            const float *time,
+            const float *eccentricity,
+            const float *semi_major_axis,
+            const float *argument_of_periapsis,
+            const float *standard_gravitational_parameter,
+            godot::Vector2 *positions,
+            godot::Vector2 *velocities
+    );
+
+    /**
+    Finds the points where two elliptic orbits around the same focus cross, relative to that focus.
+    See the OrbitElements overload for orbits around different foci.
+
+    @param points output, must hold 4 points
+    @return number of points written
+    */
+    int find_intercept_points(
+            const float eccentricity1,
+            const float semi_major_axis1,
+            const float argument_of_periapsis1,
+            const float eccentricity2,
+            const float semi_major_axis2,
+            const float argument_of_periapsis2,
+            godot::Vector2 *points
+    );
+
     bool is_circle(float eccentricity);
 
     bool is_ellipse(float eccentricity);
@@ -139,13 +270,215 @@ namespace orbits {
 
     bool is_hyperbola(float eccentricity);
 
+    // OrbitElements overloads
+
+    float get_semi_minor_axis(const OrbitElements &elements);
+
+    float get_linear_eccentricity(const OrbitElements &elements);
+
+    godot::Vector2 get_focus_point_from_centroid(const OrbitElements &elements, const godot::Vector2 centroid);
+
+    godot::Vector2 get_centroid_from_focus_point(const OrbitElements &elements, const godot::Vector2 focus);
+
+    float get_orbital_period(const OrbitElements &elements);
+
+    float get_mean_angular_motion(const OrbitElements &elements);
+
+    /**
+    Mean anomaly at time, mean_anomaly_at_epoch + n (time - epoch) reduced to [0, 2 pi). The product and the
+    reduction are carried out exactly, so the result has full double precision after any number of turns.
+    */
+    double get_mean_anomaly(const double time, const OrbitElements &elements);
+
+    float get_eccentric_anomaly_from_mean_anomaly(const float mean_anomaly, const OrbitElements &elements);
+
+    float get_eccentric_anomaly(const double time, const OrbitElements &elements);
+
+    float get_eccentric_anomaly_from_position(const godot::Vector2 position, const godot::Vector2 focus_point,
+                                              const OrbitElements &elements);
+
+    float get_true_anomaly_from_eccentric_anomaly(const float eccentric_anomaly, const OrbitElements &elements);
+
+    float get_true_anomaly_from_time(const double time, const OrbitElements &elements);
+
+    float get_heliocentric_distance_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    );
+
+    float get_heliocentric_distance_from_time(const double time, const OrbitElements &elements);
+
+    godot::Vector2 get_heliocentric_velocity_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    );
+
+    godot::Vector2 get_heliocentric_velocity_from_time(const double time, const OrbitElements &elements);
+
+    PositionVelocity2D get_heliocentric_position_velocity_from_eccentric_anomaly(
+            const float eccentric_anomaly,
+            const OrbitElements &elements
+    );
+
+    PositionVelocity2D get_heliocentric_position_velocity_from_time(const double time, const OrbitElements &elements);
+
+    void get_heliocentric_position_velocity_from_time_batch(
+            const int count,
+            const double *time,
+            const OrbitElements *elements,
+            godot::Vector2 *positions,
+            godot::Vector2 *velocities
+    );
+
+    /**
+    Tessellates the orbit into count points spaced evenly in eccentric anomaly, starting at periapsis.
+    Points are relative to the focus, with the major axis rotated by the argument of periapsis.
+
+    @param elements the orbit
+    @param count number of points to write
+    @param points output, must hold count points
+    */
+    void get_ellipse_points(const OrbitElements &elements, const int count, godot::Vector2 *points);
+
+    /**
+    Tessellates the orbit with as few points as keep every segment within max_error of the true ellipse.
+    Points are placed by curvature, so highly eccentric orbits get dense sampling around periapsis instead of
+    facets, and small orbits collapse to a handful of points.
+
+    @param elements the orbit
+    @param scale length of one orbit unit in the units of max_error (e.g. pixels per unit on screen)
+    @param max_error largest allowed distance between a segment and the ellipse
+    @param max_count upper bound on the number of points
+    @param points output, must hold max_count points, or nullptr to only count them
+    @return number of points written
+    */
+    int get_adaptive_ellipse_points(
+            const OrbitElements &elements,
+            const float scale,
+            const float max_error,
+            const int max_count,
+            godot::Vector2 *points
+    );
+
+    /**
+    Finds the points where two elliptic orbits cross. Orbit 1 is parametrized by its eccentric anomaly and
+    substituted into the implicit equation of orbit 2, which with t = tan(E / 2) becomes a quartic in t. Its real
+    roots are the crossings, polished with Newton's method on the original equation.
+
+    @param elements1 the first orbit
+    @param focus1 position of the focus of the first orbit
+    @param elements2 the second orbit
+    @param focus2 position of the focus of the second orbit
+    @param points output, must hold 4 points
+    @return number of points written, 0 when the orbits do not cross or coincide
+    */
+    int find_intercept_points(
+            const OrbitElements &elements1,
+            const godot::Vector2 focus1,
+            const OrbitElements &elements2,
+            const godot::Vector2 focus2,
+            godot::Vector2 *points
+    );
+
+    bool is_circle(const OrbitElements &elements);
+
+    bool is_ellipse(const OrbitElements &elements);
+
+    bool is_parabola(const OrbitElements &elements);
+
+    bool is_hyperbola(const OrbitElements &elements);
+
+    // Scalar type generic implementations
+    //
+    // The float functions above are the float instantiations of these, which run the Kepler solve at float
+    // precision. Instantiate them with double, e.g. orbits::get_true_anomaly_from_time<double>(...), for long
+    // duration simulation.
+
+    template <typename T>
+    inline T get_linear_eccentricity(const T eccentricity, const T semi_major_axis) {
+        return eccentricity * semi_major_axis;
+    }
+
+    template <typename T>
+    inline T get_semi_minor_axis(const T eccentricity, const T semi_major_axis) {
+        return semi_major_axis * std::sqrt(T(1) - eccentricity * eccentricity);
+    }
+
+    template <typename T>
+    inline T get_geocentric_distance(const T standard_gravitational_parameter, const T rotational_period) {
+        return std::cbrt(standard_gravitational_parameter * rotational_period * rotational_period /
+                         T(4.0 * M_PI * M_PI));
+    }
+
+    template <typename T>
+    inline T get_sphere_of_influence_radius(const T semi_major_axis, const T standard_gravitational_parameter,
+                                            const T primary_standard_gravitational_parameter) {
+        return semi_major_axis * std::pow(standard_gravitational_parameter / primary_standard_gravitational_parameter,
+                                          T(0.4));
+    }
+
+    template <typename T>
+    inline T get_orbital_period(const T semi_major_axis, const T standard_gravitational_parameter) {
+        return T(2.0 * M_PI) * std::sqrt(semi_major_axis * semi_major_axis * semi_major_axis /
+                                         standard_gravitational_parameter);
+    }
+
+    template <typename T>
+    inline T get_mean_angular_motion(const T semi_major_axis, const T standard_gravitational_parameter) {
+        return std::sqrt(standard_gravitational_parameter / (semi_major_axis * semi_major_axis * semi_major_axis));
+    }
+
+    template <typename T>
+    inline T get_mean_anomaly(const T time, const T semi_major_axis, const T standard_gravitational_parameter) {
+        // Multiplied and reduced to [0, 2 pi) in double, so a float instantiation hands the solver a correctly
+        // rounded angle instead of whatever digits a float product of a large time has left
+        const double M = static_cast<double>(get_mean_angular_motion<T>(semi_major_axis,
+                                                                        standard_gravitational_parameter)) * time;
+        return static_cast<T>(M - 2.0 * M_PI * std::floor(M / (2.0 * M_PI)));
+    }
+
+    template <typename T>
+    inline T get_eccentric_anomaly_from_mean_anomaly(const T mean_anomaly, const T eccentricity) {
+        return kepler::ecc_anomaly<T>(eccentricity, mean_anomaly);
+    }
+
+    template <typename T>
+    inline T get_eccentric_anomaly(const T time, const T eccentricity, const T semi_major_axis,
+                                   const T standard_gravitational_parameter) {
+        return kepler::ecc_anomaly<T>(eccentricity,
+                                      get_mean_anomaly<T>(time, semi_major_axis, standard_gravitational_parameter));
+    }
+
+    template <typename T>
+    inline T get_true_anomaly_from_eccentric_anomaly(const T eccentric_anomaly, const T eccentricity) {
+        const T half_E = eccentric_anomaly / T(2);
+        return T(2) * std::atan2(std::sqrt(T(1) + eccentricity) * std::sin(half_E),
+                                 std::sqrt(T(1) - eccentricity) * std::cos(half_E));
+    }
+
+    template <typename T>
+    inline T get_true_anomaly_from_time(const T time, const T eccentricity, const T semi_major_axis,
+                                        const T standard_gravitational_parameter) {
+        return get_true_anomaly_from_eccentric_anomaly<T>(
+                get_eccentric_anomaly<T>(time, eccentricity, semi_major_axis, standard_gravitational_parameter),
+                eccentricity);
+    }
+
+    template <typename T>
+    inline T get_heliocentric_distance_from_eccentric_anomaly(const T eccentric_anomaly, const T eccentricity,
+                                                              const T semi_major_axis) {
+        return semi_major_axis * (T(1) - eccentricity * std::cos(eccentric_anomaly));
+    }
+
+    template <typename T>
+    inline T get_heliocentric_distance_from_time(const T time, const T eccentricity, const T semi_major_axis,
+                                                 const T standard_gravitational_parameter) {
+        return get_heliocentric_distance_from_eccentric_anomaly<T>(
+                get_eccentric_anomaly<T>(time, eccentricity, semi_major_axis, standard_gravitational_parameter),
+                eccentricity, semi_major_axis);
+    }
+
 }
 
 // TODO
 // float time_to_true_anomaly(const float true_anomaly);
-
-// TODO
-// Vector<Vector2> find_intercept_points(
-//     const float eccentricity1, const float semi_major_axis1, const float argument_of_periapsis1,
-//     const float eccentricity2, const float semi_major_axis2, const float argument_of_periapsis2
-// );
@@ -0,0 +1,68 @@
+#include <mutex>
+#include <vector>
+
+#include "stats.hpp"
+
+namespace stats {
+
+    thread_local Counters *local_counters = nullptr;
+
+    namespace {
+        std::mutex mutex;
+        std::vector<Counters *> threads;  // counters of every thread that ever added to them
+        Frame totals = {};                // sums at the last flush
+        Frame frame = {};                 // difference between the last two flushes
+        std::atomic<uint64_t> flushed_frame(UINT64_MAX);  // frame_number of the last flush_frame
+    }
+
+    Counters *register_thread() {
+        Counters *counters = new Counters();
+        for (int i = 0; i < kepler_histogram_size; i++) {
+            counters->kepler_iterations[i].store(0, std::memory_order_relaxed);
+        }
+        counters->kepler_failures.store(0, std::memory_order_relaxed);
+        counters->bodies_propagated.store(0, std::memory_order_relaxed);
+        for (int i = 0; i < TIMER_COUNT; i++) {
+            counters->timer_ns[i].store(0, std::memory_order_relaxed);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(counters);
+        return counters;
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        Frame sums = {};
+        for (const Counters *counters : threads) {
+            for (int i = 0; i < kepler_histogram_size; i++) {
+                sums.kepler_iterations[i] += counters->kepler_iterations[i].load(std::memory_order_relaxed);
+            }
+            sums.kepler_failures += counters->kepler_failures.load(std::memory_order_relaxed);
+            sums.bodies_propagated += counters->bodies_propagated.load(std::memory_order_relaxed);
+            for (int i = 0; i < TIMER_COUNT; i++) {
+                sums.timer_ns[i] += counters->timer_ns[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        for (int i = 0; i < kepler_histogram_size; i++) {
+            frame.kepler_iterations[i] = sums.kepler_iterations[i] - totals.kepler_iterations[i];
+        }
+        frame.kepler_failures = sums.kepler_failures - totals.kepler_failures;
+        frame.bodies_propagated = sums.bodies_propagated - totals.bodies_propagated;
+        for (int i = 0; i < TIMER_COUNT; i++) {
+            frame.timer_ns[i] = sums.timer_ns[i] - totals.timer_ns[i];
+        }
+        totals = sums;
+    }
+
+    void flush_frame(const uint64_t frame_number) {
+        if (flushed_frame.exchange(frame_number, std::memory_order_relaxed) != frame_number) flush();
+    }
+
+    Frame get_frame() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return frame;
+    }
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace stats {
+
+    // Counters and timers of the solver and the propagation, cheap enough to stay on in release builds.
+    //
+    // Every thread adds to counters of its own, so the hot paths pay a thread local lookup and a plain add instead
+    // of a locked instruction on a shared cache line. flush, called once per frame, sums the counters of every
+    // thread and keeps the difference to the previous flush as the numbers of that frame. Every node that produces
+    // counts ends the frame through flush_frame on its first callback of the frame, so no single node has to be in
+    // the scene for the numbers to be published.
+
+    // Buckets of the Kepler iteration histogram, the last one also counts every solve that took more corrections
+    static const int kepler_histogram_size = 9;
+
+    enum Timer {
+        TIMER_PROPAGATION,
+        TIMER_TESSELLATION,
+        TIMER_GENERATE_PATH,
+        TIMER_COUNT
+    };
+
+    struct Frame {
+        uint64_t kepler_iterations[kepler_histogram_size];  // solves by number of corrections
+        uint64_t kepler_failures;                           // solves that gave up before converging
+        uint64_t bodies_propagated;
+        uint64_t timer_ns[TIMER_COUNT];
+    };
+
+    /**
+    Running totals of one thread. Only the owning thread writes them, flush reads them from another thread, so a
+    relaxed load and store stand in for an atomic add.
+    */
+    struct Counters {
+        std::atomic<uint64_t> kepler_iterations[kepler_histogram_size];
+        std::atomic<uint64_t> kepler_failures;
+        std::atomic<uint64_t> bodies_propagated;
+        std::atomic<uint64_t> timer_ns[TIMER_COUNT];
+    };
+
+    /**
+    Creates the counters of the calling thread. They are never freed, the engine and the job pool keep their
+    threads for the lifetime of the process and the counts of a thread that did exit still add up that way.
+    */
+    Counters *register_thread();
+
+    extern thread_local Counters *local_counters;
+
+    inline Counters &get_local_counters() {
+        if (!local_counters) local_counters = register_thread();
+        return *local_counters;
+    }
+
+    inline void add(std::atomic<uint64_t> &counter, const uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    /**
+    @param iterations number of corrections the solve applied
+    @param converged false when the solver hit its iteration limit and returned whatever it had
+    */
+    inline void add_kepler_solve(const int iterations, const bool converged) {
+        Counters &counters = get_local_counters();
+        const int bucket = iterations < kepler_histogram_size ? iterations : kepler_histogram_size - 1;
+        add(counters.kepler_iterations[bucket], 1);
+        if (!converged) add(counters.kepler_failures, 1);
+    }
+
+    /**
+    Adds the solves of a whole batch at once.
+
+    @param histogram solves by number of corrections, kepler_histogram_size buckets
+    @param failures solves that did not converge
+    */
+    inline void add_kepler_solves(const uint64_t *histogram, const uint64_t failures) {
+        Counters &counters = get_local_counters();
+        for (int i = 0; i < kepler_histogram_size; i++) {
+            if (histogram[i]) add(counters.kepler_iterations[i], histogram[i]);
+        }
+        if (failures) add(counters.kepler_failures, failures);
+    }
+
+    inline void add_bodies_propagated(const int count) {
+        add(get_local_counters().bodies_propagated, static_cast<uint64_t>(count));
+    }
+
+    inline void add_time(const Timer timer, const uint64_t ns) {
+        add(get_local_counters().timer_ns[timer], ns);
+    }
+
+    /**
+    Adds the time until it goes out of scope to a timer.
+    */
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(const Timer timer) : timer(timer), start(std::chrono::steady_clock::now()) {}
+
+        ~ScopedTimer() {
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            add_time(timer, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+
+        ScopedTimer(const ScopedTimer &) = delete;
+
+        ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    private:
+        const Timer timer;
+        const std::chrono::steady_clock::time_point start;
+    };
+
+    /**
+    Ends the current frame: sums the counters of every thread and keeps what was added since the previous flush
+    for get_frame. Meant to be called once per frame, from a single thread.
+    */
+    void flush();
+
+    /**
+    flush, once per frame however many nodes call it: the first call with a new frame_number ends the frame, the
+    calls after it with the same number do nothing.
+
+    @param frame_number the engine's frame counter
+    */
+    void flush_frame(const uint64_t frame_number);
+
+    /**
+    @return the counts of the frame ended by the last flush
+    */
+    Frame get_frame();
+
+}
@@ -0,0 +1,81 @@
+// Event searches restarted from the time of the event they returned, as the event loop of OrbitSystem2D does, must
+// move on to the next event, and the queue must refuse events that would never come due. Built against the headless
+// core library and run by:
+//     scons platform=<platform> test
+
+#include <cmath>
+#include <cstdio>
+
+#include "orbit_events.hpp"
+#include "orbit_overlap.hpp"
+
+namespace {
+
+    int failures = 0;
+
+    void check(const bool passed, const char *what) {
+        failures += !passed;
+        printf("%s %s\n", passed ? "ok  " : "FAIL", what);
+    }
+
+    /**
+    Chains count searches, each from the result of the last, and checks they advance by about one period each.
+    */
+    template<typename Search>
+    bool chains_by_period(const double start, const int count, const double period, Search search) {
+        double time = start;
+        for (int i = 0; i < count; i++) {
+            const double next = search(time);
+            if (!(next > time) || (i > 0 && std::fabs(next - time - period) > 1e-6 * period)) return false;
+            time = next;
+        }
+        return true;
+    }
+
+}
+
+int main() {
+    const orbits::OrbitElements elements = orbits::get_orbit_elements(0.5f, 100.0f, 0.3f, 1000.0f, 0.0, 1.0);
+    const double period = elements.orbital_period;
+
+    check(chains_by_period(0.0, 1000, period, [&](const double time) {
+        return orbits::get_next_periapsis_time(time, elements);
+    }), "periapsis searched again from its own time is one period later");
+    check(chains_by_period(1e11, 1000, period, [&](const double time) {
+        return orbits::get_next_periapsis_time(time, elements);
+    }), "same 1e11 s out");
+
+    // Periapsis at 50 and apoapsis at 150
+    check(chains_by_period(0.0, 1000, period, [&](const double time) {
+        return orbits::get_next_soi_exit_time(time, elements, 120.0);
+    }), "sphere of influence exit searched again from its own time is one period later");
+    check(chains_by_period(1e11, 1000, period, [&](const double time) {
+        return orbits::get_next_soi_exit_time(time, elements, 120.0);
+    }), "same 1e11 s out");
+    check(std::isinf(orbits::get_next_soi_exit_time(0.0, elements, 200.0)), "no exit from a sphere the orbit is inside");
+    check(std::isinf(orbits::get_next_soi_exit_time(0.0, elements, 40.0)), "no exit from a sphere the orbit is outside");
+
+    // Circular orbits 10 apart with bodies of radius 6, in contact for a while around every conjunction
+    const godot::Vector2 focus(0.0f, 0.0f);
+    const orbits::OrbitElements inner = orbits::get_orbit_elements(0.0f, 100.0f, 0.0f, 1000.0f, 0.0, 0.0);
+    const orbits::OrbitElements outer = orbits::get_orbit_elements(0.0f, 110.0f, 0.0f, 1000.0f, 0.0, 1.0);
+    const double synodic_period = 1.0 / (1.0 / inner.orbital_period - 1.0 / outer.orbital_period);
+    const auto contact = [&](const double time) {
+        return orbits::find_next_contact_time(inner, focus, 6.0f, outer, focus, 6.0f, time, time + 2.0 * synodic_period,
+                                              1e-6);
+    };
+    check(chains_by_period(0.0, 5, synodic_period, contact), "contact searched again from its own time is one "
+                                                             "conjunction later");
+
+    orbits::OrbitEventQueue queue;
+    queue.reset(2);
+    queue.push({NAN, orbits::ORBIT_EVENT_PERIAPSIS, 0, -1});
+    queue.push({INFINITY, orbits::ORBIT_EVENT_PERIAPSIS, 0, -1});
+    check(queue.get_pending_count() == 0, "queue refuses events at times that are not finite");
+    queue.push({1.0, orbits::ORBIT_EVENT_COLLISION, 0, 1});
+    queue.invalidate(1);
+    orbits::OrbitEvent event;
+    check(!queue.pop(2.0, event), "queue drops collisions of an invalidated other body");
+
+    return failures;
+}
@@ -0,0 +1,60 @@
+// The float, batch and elements paths of the Kepler solver against the double solver, up to nearly parabolic
+// orbits. Built against the headless core library and run by:
+//     scons platform=<platform> test
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "kepler.hpp"
+#include "orbits.hpp"
+
+namespace {
+
+    const int sample_count = 20000;
+
+    /**
+    Distance between two eccentric anomalies, ignoring whole turns.
+    */
+    double get_angle_error(const double a, const double b) {
+        return std::fabs(std::remainder(a - b, 2.0 * M_PI));
+    }
+
+}
+
+int main() {
+    const float eccentricities[] = {0.0f, 0.5f, 0.9f, 0.95f, 0.98f, 0.99f, 0.9989f, 0.999f, 0.9999f, 0.99995f,
+                                    0.99999f};
+
+    int failures = 0;
+    for (const float e : eccentricities) {
+        const orbits::OrbitElements elements = orbits::get_orbit_elements(e, 100.0f, 0.0f, 1000.0f, 0.0, 0.0);
+        std::vector<double> ecc(sample_count, e), mean_anomaly(sample_count), batch(sample_count);
+        for (int i = 0; i < sample_count; i++) {
+            // Float mean anomalies, so every path solves the same equation, dense around periapsis
+            const double u = 2.0 * i / (sample_count - 1) - 1.0;
+            mean_anomaly[i] = static_cast<float>(M_PI * u * u * u);
+        }
+        kepler::ecc_anomaly_batch(ecc.data(), mean_anomaly.data(), batch.data(), sample_count);
+
+        double residual = 0.0, float_error = 0.0, elements_error = 0.0, batch_error = 0.0;
+        for (int i = 0; i < sample_count; i++) {
+            const double M = mean_anomaly[i];
+            const double E = kepler::ecc_anomaly<double>(e, M);
+            residual = std::fmax(residual, std::fabs(E - static_cast<double>(e) * std::sin(E) - M));
+            float_error = std::fmax(float_error, get_angle_error(kepler::ecc_anomaly<float>(e, M), E));
+            elements_error = std::fmax(elements_error, get_angle_error(
+                    orbits::get_eccentric_anomaly_from_mean_anomaly(static_cast<float>(M), elements), E));
+            batch_error = std::fmax(batch_error, get_angle_error(batch[i], E));
+        }
+
+        // The double solver solves Kepler's equation, the others round its solution to float or reach the same
+        const bool passed = residual <= 1e-13 && float_error <= 4.0 * FLT_EPSILON * M_PI
+                && elements_error <= FLT_EPSILON * M_PI && batch_error <= 1e-12;
+        failures += !passed;
+        printf("%s e = %g: residual %.3g, float %.3g, elements %.3g, batch %.3g rad\n", passed ? "ok  " : "FAIL",
+               e, residual, float_error, elements_error, batch_error);
+    }
+    return failures;
+}
@@ -0,0 +1,74 @@
+// Precision of the mean anomaly far from the epoch, against a quad precision reference. Built against the headless
+// core library and run by:
+//     scons platform=<platform> test
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "orbits.hpp"
+
+#ifdef __SIZEOF_FLOAT128__
+
+namespace {
+
+    typedef __float128 quad;
+
+    // Largest error accepted, in radians, a little over one ulp of 2 pi
+    const double max_error = 1.3e-15;
+
+    /**
+    M0 + n (time - epoch) reduced to [0, 2 pi), all of it in quad precision.
+    */
+    double get_reference(const orbits::OrbitElements &elements, const double time) {
+        // 2 pi to about 1e-32 as the sum of its two nearest doubles
+        const quad two_pi = static_cast<quad>(6.283185307179586) + static_cast<quad>(2.4492935982947064e-16);
+        const quad M = static_cast<quad>(elements.mean_anomaly_at_epoch) + static_cast<quad>(elements.mean_angular_motion)
+                * (static_cast<quad>(time) - static_cast<quad>(elements.epoch));
+        quad turns = static_cast<quad>(static_cast<long long>(M / two_pi));
+        quad reduced = M - turns * two_pi;
+        if (reduced < 0) reduced += two_pi;
+        if (reduced >= two_pi) reduced -= two_pi;
+        return static_cast<double>(reduced);
+    }
+
+    /**
+    Distance between two angles around the circle.
+    */
+    double get_angle_error(const double a, const double b) {
+        const double d = std::fabs(a - b);
+        return std::fmin(d, 2.0 * M_PI - d);
+    }
+
+}
+
+int main() {
+    std::mt19937 rng(16);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const double times[] = {0.0, 1.0, 1e6, 1e9, 1e11, 1e12, -1e12};
+
+    int failures = 0;
+    for (const double time : times) {
+        double worst = 0.0;
+        for (int k = 0; k < 1000; k++) {
+            const orbits::OrbitElements elements = orbits::get_orbit_elements(
+                    0.9 * unit(rng), 10.0 + 990.0 * unit(rng), 2.0 * M_PI * unit(rng), 1000.0,
+                    1e6 * (unit(rng) - 0.5), 100.0 * (unit(rng) - 0.5));
+            worst = std::fmax(worst, get_angle_error(orbits::get_mean_anomaly(time, elements),
+                                                     get_reference(elements, time)));
+        }
+        const bool passed = worst <= max_error;
+        failures += !passed;
+        printf("%s t = %g: largest error %.3g rad\n", passed ? "ok  " : "FAIL", time, worst);
+    }
+    return failures;
+}
+
+#else
+
+int main() {
+    printf("skipped, the compiler has no quad precision type\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,93 @@
+// Nearest point of an orbit against a brute force search over the eccentric anomaly, up to e = 0.9999. Built
+// against the headless core library and run by:
+//     scons platform=<platform> test
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "orbit_nearest.hpp"
+
+namespace {
+
+    const int grid_size = 4096;
+
+    /**
+    Squared distance from (x, y) to the point of eccentric anomaly E, in the frame of the ellipse.
+    */
+    double get_distance2(const double a, const double b, const double x, const double y, const double E) {
+        const double dx = a * std::cos(E) - x;
+        const double dy = b * std::sin(E) - y;
+        return dx * dx + dy * dy;
+    }
+
+    /**
+    Distance from position to the orbit, by sampling the eccentric anomaly on a grid and refining the best sample
+    with a golden section search.
+    */
+    double get_reference_distance(const orbits::OrbitElements &elements, const godot::Vector2 focus,
+                                  const godot::Vector2 position) {
+        const double a = elements.semi_major_axis;
+        const double b = elements.semi_minor_axis;
+        const double cos_w = elements.cos_argument_of_periapsis;
+        const double sin_w = elements.sin_argument_of_periapsis;
+        const double dx = static_cast<double>(position.x) - focus.x + elements.linear_eccentricity * cos_w;
+        const double dy = static_cast<double>(position.y) - focus.y + elements.linear_eccentricity * sin_w;
+        const double x = dx * cos_w + dy * sin_w;
+        const double y = dy * cos_w - dx * sin_w;
+
+        const double step = 2.0 * M_PI / grid_size;
+        double best_E = 0.0;
+        double best = INFINITY;
+        for (int i = 0; i < grid_size; i++) {
+            const double distance2 = get_distance2(a, b, x, y, i * step);
+            if (distance2 < best) {
+                best = distance2;
+                best_E = i * step;
+            }
+        }
+
+        const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+        double lo = best_E - step;
+        double hi = best_E + step;
+        for (int i = 0; i < 100; i++) {
+            const double m1 = hi - ratio * (hi - lo);
+            const double m2 = lo + ratio * (hi - lo);
+            if (get_distance2(a, b, x, y, m1) < get_distance2(a, b, x, y, m2)) hi = m2;
+            else lo = m1;
+        }
+        return std::sqrt(std::fmin(best, get_distance2(a, b, x, y, (lo + hi) / 2.0)));
+    }
+
+}
+
+int main() {
+    std::mt19937 rng(24);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const double eccentricities[] = {0.0, 0.1, 0.5, 0.9, 0.99, 0.999, 0.9999};
+    const godot::Vector2 focus(30.0f, -20.0f);
+
+    int failures = 0;
+    for (const double e : eccentricities) {
+        const orbits::OrbitElements elements = orbits::get_orbit_elements(
+                static_cast<float>(e), 100.0f, 0.7f, 1000.0f, 0.0, 0.0);
+        double worst = 0.0;
+        for (int k = 0; k < 1000; k++) {
+            // Points inside and outside the ellipse, out to a few times its size
+            const double r = 250.0 * unit(rng);
+            const double angle = 2.0 * M_PI * unit(rng);
+            const godot::Vector2 position(focus.x + static_cast<float>(r * std::cos(angle)),
+                                          focus.y + static_cast<float>(r * std::sin(angle)));
+            const orbits::NearestPoint nearest = orbits::get_nearest_point(elements, focus, position, 0.0);
+            const double reference = get_reference_distance(elements, focus, position);
+            // In float ulps of the distance, which is only a float, with the ulp floored for points on the orbit
+            const double ulp = FLT_EPSILON * std::fmax(reference, 1e-6 * elements.semi_major_axis);
+            worst = std::fmax(worst, std::fabs(nearest.distance - reference) / ulp);
+        }
+        const bool passed = worst <= 1.0;
+        failures += !passed;
+        printf("%s e = %g: largest error %.3g ulp\n", passed ? "ok  " : "FAIL", e, worst);
+    }
+    return failures;
+}
@@ -0,0 +1,99 @@
+// Contact times of pairs of orbiting bodies against a brute force scan, and termination of the search where the
+// window is narrower than the spacing of doubles allows to split. Built against the headless core library and run
+// by:
+//     scons platform=<platform> test
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "orbit_overlap.hpp"
+
+namespace {
+
+    const float radius = 5.0f;
+    const double window = 500.0;
+    const double scan_step = 2e-3;
+
+    /**
+    Distance between the centres of the two bodies at time.
+    */
+    double get_separation(const orbits::OrbitElements &elements1, const orbits::OrbitElements &elements2,
+                          const double time) {
+        const godot::Vector2 p1 = orbits::get_heliocentric_position_velocity_from_time(time, elements1).p;
+        const godot::Vector2 p2 = orbits::get_heliocentric_position_velocity_from_time(time, elements2).p;
+        return std::hypot(static_cast<double>(p1.x) - p2.x, static_cast<double>(p1.y) - p2.y);
+    }
+
+    /**
+    First time the bodies, apart at 0, are sampled in contact, or infinity.
+    */
+    double scan_for_contact(const orbits::OrbitElements &elements1, const orbits::OrbitElements &elements2) {
+        for (double time = 0.0; time <= window; time += scan_step) {
+            if (get_separation(elements1, elements2, time) <= 2.0 * radius) return time;
+        }
+        return INFINITY;
+    }
+
+    /**
+    Random pairs around one primary, every contact found must be a real one and no later than the scan finds one.
+    */
+    int check_against_scan() {
+        std::mt19937 rng(14);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        const godot::Vector2 focus(0.0f, 0.0f);
+
+        int failures = 0, pairs = 0, contacts = 0;
+        for (int k = 0; k < 20; k++) {
+            orbits::OrbitElements elements[2];
+            for (orbits::OrbitElements &orbit : elements) {
+                orbit = orbits::get_orbit_elements(static_cast<float>(0.6 * unit(rng)),
+                                                   static_cast<float>(50.0 + 100.0 * unit(rng)),
+                                                   static_cast<float>(2.0 * M_PI * unit(rng)), 1000.0f,
+                                                   0.0, 2.0 * M_PI * unit(rng));
+            }
+            if (get_separation(elements[0], elements[1], 0.0) <= 2.0 * radius) continue;
+            pairs++;
+
+            const double found = orbits::find_next_overlap_time(elements[0], focus, radius, elements[1], focus, radius,
+                                                                0.0, window, 1e-6);
+            const double scanned = scan_for_contact(elements[0], elements[1]);
+            bool passed = !(found > scanned) && !(found < scanned - scan_step);
+            if (std::isfinite(found)) {
+                contacts++;
+                passed = passed && std::fabs(get_separation(elements[0], elements[1], found) - 2.0 * radius) < 1e-3;
+            }
+            if (!passed) {
+                failures++;
+                printf("FAIL pair %d: contact at %.9g, scan finds %.9g\n", k, found, scanned);
+            }
+        }
+        printf("%s %d pairs, %d of them in contact, against the scan\n", failures ? "FAIL" : "ok  ", pairs, contacts);
+        return failures;
+    }
+
+    /**
+    A window around a contact 1e11 s out, with a tolerance far below the 1.5e-5 s between doubles there. The search
+    has to stop splitting once the midpoint rounds onto an end of the interval.
+    */
+    int check_termination_far_out() {
+        const godot::Vector2 focus(0.0f, 0.0f);
+        const orbits::OrbitElements elements1 = orbits::get_orbit_elements(0.0f, 100.0f, 0.0f, 1000.0f, 0.0, 0.0);
+        const orbits::OrbitElements elements2 = orbits::get_orbit_elements(0.5f, 120.0f, 1.0f, 1000.0f, 0.0, 2.0);
+
+        const double contact = orbits::find_next_overlap_time(elements1, focus, radius, elements2, focus, radius,
+                                                              1e11, 1e11 + 1e4, 1e-3);
+        const double refined = orbits::find_next_overlap_time(elements1, focus, radius, elements2, focus, radius,
+                                                              contact - 1.0, contact, 0.0);
+        const double found = orbits::find_next_overlap_time(elements1, focus, radius, elements2, focus, radius,
+                                                            refined - 0.001, refined + 0.009, 0.01 / 65536);
+        const bool passed = std::isfinite(contact) && found >= refined - 0.001 && found <= refined + 0.009;
+        printf("%s contact near 1e11 s found at %.17g\n", passed ? "ok  " : "FAIL", found);
+        return !passed;
+    }
+
+}
+
+int main() {
+    return check_against_scan() + check_termination_far_out();
+}
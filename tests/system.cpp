@@ -0,0 +1,97 @@
+// The orbit system behind OrbitSystem2D without the engine: events in time order with handlers that change the
+// bodies, moons carried by their planets, and bodies going off rails under thrust and back once it stops. Built
+// against the headless core library and run by:
+//     scons platform=<platform> test
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "orbit_system.hpp"
+
+namespace {
+
+    int failures = 0;
+
+    void check(const bool passed, const char *what) {
+        failures += !passed;
+        printf("%s %s\n", passed ? "ok  " : "FAIL", what);
+    }
+
+    double get_distance(const godot::Vector2 p1, const godot::Vector2 p2) {
+        return std::hypot(static_cast<double>(p1.x) - p2.x, static_cast<double>(p1.y) - p2.y);
+    }
+
+}
+
+int main() {
+    {
+        orbits::OrbitSystem system;
+        system.set_standard_gravitational_parameter(1000.0f);
+        const int body = system.add_body(0.5f, 100.0f, 0.0f, 0.0, 0.0);
+        check(system.add_body(0.5f, 0.0f, 0.0f, 0.0, 0.0) == -1, "bodies with no semi-major axis are refused");
+        check(system.add_body(1.0f, 100.0f, 0.0f, 0.0, 0.0) == -1, "parabolic elements are refused");
+        check(!system.set_body(body, 1.5f, 100.0f, 0.0f, 0.0, 0.0), "hyperbolic elements are refused");
+
+        // Periapsis passages every period, in order, and still so when the handler moves the body on every one
+        const double period = orbits::get_orbit_elements(0.5f, 100.0f, 0.0f, 1000.0f, 0.0, 0.0).orbital_period;
+        std::vector<double> times;
+        for (int step = 0; step < 100; step++) {
+            system.advance(period / 7.0, [&](const orbits::OrbitEvent &event) {
+                times.push_back(event.time);
+                system.set_body_radius(event.body, 1.0f);
+            });
+        }
+        bool by_period = times.size() >= 14;
+        for (int k = 1; k < static_cast<int>(times.size()); k++) {
+            by_period = by_period && std::fabs(times[k] - times[k - 1] - period) <= 1e-9 * period;
+        }
+        check(by_period, "periapsis events one period apart with a handler changing the body");
+    }
+
+    {
+        // A moon around a planet: its focus is the planet wherever the planet is
+        orbits::OrbitSystem system;
+        system.set_standard_gravitational_parameter(1000.0f);
+        const int planet = system.add_body(0.1f, 500.0f, 0.5f, 0.0, 0.0);
+        const int moon = system.add_body(0.2f, 20.0f, 0.0f, 0.0, 0.0);
+        system.set_body_standard_gravitational_parameter(planet, 10.0f);
+        check(system.set_body_parent(moon, planet), "a moon can orbit a planet");
+        check(!system.set_body_parent(planet, moon), "a planet cannot orbit its own moon");
+        system.set_time(123.0);
+        system.propagate();
+        const std::vector<godot::Vector2> &positions = system.get_positions();
+        const double distance = get_distance(positions[moon], positions[planet]);
+        check(distance >= 20.0 * 0.8 - 1e-3 && distance <= 20.0 * 1.2 + 1e-3, "the moon stays around the planet");
+        check(system.get_focus(moon) == positions[planet], "the focus of the moon is the planet");
+
+        // Removing the planet hands the moon to the origin
+        system.remove_body(planet);
+        check(system.get_body_count() == 1 && system.get_body_parent(0) == -1, "moons of a removed body move up");
+        check(!system.is_propagated(), "positions are stale until the next propagation");
+    }
+
+    {
+        // Thrust takes a body off rails, and it is fitted back onto the orbit it ended on once the thrust stops
+        orbits::OrbitSystem system;
+        system.set_standard_gravitational_parameter(1000.0f);
+        const int body = system.add_body(0.0f, 100.0f, 0.0f, 0.0, 0.0);
+        system.propagate();
+        system.set_body_thrust(body, godot::Vector2(0.01f, 0.0f));
+        check(system.is_body_off_rails(body), "a thrusting body leaves its elements");
+        for (int step = 0; step < 60; step++) {
+            system.set_time(system.get_time() + 0.1);
+            system.propagate();
+        }
+        const godot::Vector2 position = system.get_positions()[body];
+        const godot::Vector2 velocity = system.get_velocities()[body];
+        system.set_body_thrust(body, godot::Vector2());
+        check(!system.is_body_off_rails(body), "it goes back on rails once the thrust stops");
+        system.propagate();
+        check(get_distance(system.get_positions()[body], position) <= 1e-3
+              && get_distance(system.get_velocities()[body], velocity) <= 1e-4,
+              "on the orbit it ended up on");
+    }
+
+    return failures;
+}
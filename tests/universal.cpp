@@ -0,0 +1,91 @@
+// Universal variable propagation of fast, nearly radial hyperbolic flybys against a numerical integration of the
+// same two body problem. Built against the headless core library and run by:
+//     scons platform=<platform> test
+
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+#include "orbit_universal.hpp"
+
+namespace {
+
+    const double mu = 1000.0;
+
+    // Fraction of the local dynamical time per step of the reference integration
+    const double step_fraction = 1e-3;
+
+    orbits::StateVector2D get_derivative(const orbits::StateVector2D &s) {
+        const double r = std::sqrt(s.x * s.x + s.y * s.y);
+        const double k = -mu / (r * r * r);
+        return {s.vx, s.vy, k * s.x, k * s.y};
+    }
+
+    orbits::StateVector2D add(const orbits::StateVector2D &s, const orbits::StateVector2D &d, const double h) {
+        return {s.x + h * d.x, s.y + h * d.y, s.vx + h * d.vx, s.vy + h * d.vy};
+    }
+
+    /**
+    Classic Runge-Kutta with the step scaled to the time the body takes to cover its distance to the primary, so
+    it stays accurate through periapsis however close the pass.
+    */
+    orbits::StateVector2D integrate(orbits::StateVector2D s, const double duration) {
+        double time = 0.0;
+        while (time < duration) {
+            const double r = std::sqrt(s.x * s.x + s.y * s.y);
+            const double v = std::sqrt(s.vx * s.vx + s.vy * s.vy);
+            const double h = std::fmin(step_fraction * std::fmin(r / v, std::sqrt(r * r * r / mu)), duration - time);
+            const orbits::StateVector2D k1 = get_derivative(s);
+            const orbits::StateVector2D k2 = get_derivative(add(s, k1, 0.5 * h));
+            const orbits::StateVector2D k3 = get_derivative(add(s, k2, 0.5 * h));
+            const orbits::StateVector2D k4 = get_derivative(add(s, k3, h));
+            s = add(add(add(add(s, k1, h / 6.0), k2, h / 3.0), k3, h / 3.0), k4, h / 6.0);
+            time += h;
+        }
+        return s;
+    }
+
+}
+
+int main() {
+    std::mt19937 rng(25);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // The pass the Laguerre-Conway iteration used to blow up on
+    int failures = 0;
+    {
+        orbits::StateVector2D state = {57.1961, 92.5221, -119.558, -193.266};
+        const orbits::StateVector2D reference = integrate(state, 1.3);
+        orbits::propagate_universal(state, mu, 1.3);
+        const double error = std::hypot(state.x - reference.x, state.y - reference.y);
+        const bool passed = error <= 1e-6 * std::hypot(reference.x, reference.y);
+        failures += !passed;
+        printf("%s known divergent pass, off by %.3g\n", passed ? "ok  " : "FAIL", error);
+    }
+
+    // Inbound within 0.1 rad of radial, at 1.01 to 81 times the escape speed
+    const int count = 300;
+    int wrong = 0;
+    double worst = 0.0;
+    for (int k = 0; k < count; k++) {
+        const double r = 50.0 + 100.0 * unit(rng);
+        const double angle = 2.0 * M_PI * unit(rng);
+        const double speed = std::sqrt(2.0 * mu / r) * std::exp(std::log(1.01) + (std::log(81.0) - std::log(1.01))
+                * unit(rng));
+        const double heading = angle + M_PI + 0.2 * (unit(rng) - 0.5);
+        orbits::StateVector2D state = {r * std::cos(angle), r * std::sin(angle), speed * std::cos(heading),
+                                       speed * std::sin(heading)};
+        const double duration = 4.0 * r / speed * unit(rng);
+
+        const orbits::StateVector2D reference = integrate(state, duration);
+        orbits::propagate_universal(state, mu, duration);
+        const double error = std::hypot(state.x - reference.x, state.y - reference.y)
+                / std::hypot(reference.x, reference.y);
+        worst = std::fmax(worst, error);
+        wrong += !(error <= 1e-6);
+    }
+    failures += wrong;
+    printf("%s %d of %d nearly radial flybys off, largest relative error %.3g\n", wrong ? "FAIL" : "ok  ", wrong,
+           count, worst);
+    return failures;
+}